@@ -0,0 +1,333 @@
+// Headless scaling benchmark for the aquarium simulation.
+//
+// Steps the player and AquariumGameScene::Tick() (player collisions plus
+// Aquarium::update) for N creatures over M ticks and prints one JSON object
+// with ns/tick, heap allocations/tick and tick time percentiles.
+//
+//   aquarium-bench [--creatures N] [--ticks M] [--warmup K] [--seed S]
+//                  [--width W] [--height H] [--threads T] [--level-target S]
+//                  [--spawn-budget B] [--snapshot FILE] [--view-width W --view-height H]
+//                  [--activity-radius R] [--flocking 1] [--solver-iterations I]
+//                  [--island-sleep 1]
+//   aquarium-bench --replay FILE [--threads T]
+//
+// "checksum" hashes the final creature state; it must not change with --threads.
+// With --level-target the tank alternates between a level of N fish and one of
+// N/2, each completed after S points, to measure level transitions too.
+// --spawn-budget sets the fish spawned per tick (0 spawns a whole level at once).
+// --snapshot saves the final state to FILE, restores it into a fresh tank and
+// prints a second line with the save and restore times.
+// --view-width/--view-height also time a batched draw through a camera of that
+// size following the player after every tick (draw_ns, drawn_per_draw).
+// --activity-radius turns on activity regions: full rate within R of the
+// player, reduced rate up to 4R, asleep beyond (awake_per_tick).
+// --flocking 1 steers the fish as schools before every move (see flock-bench).
+// --solver-iterations caps the relaxation rounds per contact island and
+// --island-sleep 1 lets resting islands sleep (contacts_per_tick,
+// islands_per_tick, sleeping_per_tick).
+// --replay runs a session recorded by the game (--record FILE) as fast as
+// possible with the game's own levels, and prints ns per frame instead.
+
+#include "Aquarium.h"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+// ---------------- ALLOCATION COUNTER ----------------
+static std::atomic<unsigned long long> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// ---------------- BENCH LEVEL ----------------
+// Eaten fish are respawned, so the population stays at `population` until the
+// level completes. The mix follows Level_4: half small fish, then bigger, fast
+// and armored.
+class BenchLevel : public AquariumLevel {
+public:
+    BenchLevel(int number, int population, int targetScore) : AquariumLevel(number, targetScore) {
+        int bigger = population / 4;
+        int fast = population / 6;
+        int armored = population / 12;
+        int npc = population - bigger - fast - armored;
+        m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, npc));
+        m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, bigger));
+        m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::FastFish, fast));
+        m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::ArmoredFish, armored));
+    }
+};
+
+struct BenchOptions {
+    int creatures = 1000;
+    int ticks = 600;
+    int warmup = 60;
+    unsigned seed = 1;
+    int width = 1024;
+    int height = 768;
+    int threads = 0; // 0 keeps the aquarium's default, one per core
+    int levelTarget = 0; // 0 keeps a single level that never completes
+    int spawnBudget = -1; // -1 keeps the aquarium's default
+    int viewWidth = 0;    // 0 skips the draw timing
+    int viewHeight = 0;
+    int activityRadius = 0; // 0 updates every fish every tick
+    int flocking = 0;
+    int solverIterations = 0; // 0 keeps the aquarium's default
+    int islandSleep = 0;
+    std::string replay;
+    std::string snapshot;
+};
+
+static bool ParseOptions(int argc, char** argv, BenchOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "missing value for %s\n", arg);
+            return false;
+        }
+        if (!std::strcmp(arg, "--replay")) {
+            opt.replay = argv[++i];
+            continue;
+        }
+        if (!std::strcmp(arg, "--snapshot")) {
+            opt.snapshot = argv[++i];
+            continue;
+        }
+        int value = std::atoi(argv[++i]);
+        if (!std::strcmp(arg, "--creatures")) opt.creatures = value;
+        else if (!std::strcmp(arg, "--ticks")) opt.ticks = value;
+        else if (!std::strcmp(arg, "--warmup")) opt.warmup = value;
+        else if (!std::strcmp(arg, "--seed")) opt.seed = static_cast<unsigned>(value);
+        else if (!std::strcmp(arg, "--width")) opt.width = value;
+        else if (!std::strcmp(arg, "--height")) opt.height = value;
+        else if (!std::strcmp(arg, "--threads")) opt.threads = value;
+        else if (!std::strcmp(arg, "--level-target")) opt.levelTarget = value;
+        else if (!std::strcmp(arg, "--spawn-budget")) opt.spawnBudget = value;
+        else if (!std::strcmp(arg, "--view-width")) opt.viewWidth = value;
+        else if (!std::strcmp(arg, "--view-height")) opt.viewHeight = value;
+        else if (!std::strcmp(arg, "--activity-radius")) opt.activityRadius = value;
+        else if (!std::strcmp(arg, "--flocking")) opt.flocking = value;
+        else if (!std::strcmp(arg, "--solver-iterations")) opt.solverIterations = value;
+        else if (!std::strcmp(arg, "--island-sleep")) opt.islandSleep = value;
+        else {
+            std::fprintf(stderr, "unknown option %s\n", arg);
+            return false;
+        }
+    }
+    return opt.creatures >= 0 && opt.ticks > 0 && opt.warmup >= 0 && opt.width > 0 && opt.height > 0 && opt.threads >= 0 && opt.levelTarget >= 0;
+}
+
+static double Percentile(std::vector<double> samples, double p) {
+    size_t k = static_cast<size_t>(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    return samples[k];
+}
+
+// FNV-1a over the raw bits of every creature's position and direction
+static unsigned long long StateChecksum(const AquariumCreatureStore& s) {
+    unsigned long long h = 1469598103934665603ull;
+    auto mix = [&h](const std::vector<float>& column) {
+        for (float v : column) {
+            unsigned int bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+            h = (h ^ bits) * 1099511628211ull;
+        }
+    };
+    mix(s.x);
+    mix(s.y);
+    mix(s.dx);
+    mix(s.dy);
+    return h;
+}
+
+// Every recorded frame with its input, timed per frame
+static int RunReplay(const BenchOptions& opt) {
+    SessionReplay replay;
+    if (!replay.open(opt.replay)) return 1;
+    auto scene = CreateAquariumGame(replay.getWidth(), replay.getHeight(), std::make_shared<AquariumSpriteManager>(),
+                                    replay.getSeed(), kAquariumPlayerSpeed, "replay");
+    if (opt.threads > 0) scene->GetAquarium()->setWorkerThreads(opt.threads);
+
+    std::vector<double> frameNs;
+    std::vector<InputCommand> commands;
+    double frameSeconds = 0.0;
+    while (!scene->IsGameOver() && replay.nextFrame(frameSeconds, commands)) {
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &command : commands) scene->HandleInput(command);
+        scene->Advance(frameSeconds);
+        scene->GetEvents().dispatch();
+        frameNs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    if (frameNs.empty()) frameNs.push_back(0.0);
+
+    double total = 0.0;
+    for (double ns : frameNs) total += ns;
+    std::printf("{\"replay\": \"%s\", \"seed\": %llu, \"frames\": %zu, \"threads\": %d, \"ns_per_frame\": %.1f, "
+                "\"p50_ns\": %.1f, \"p99_ns\": %.1f, \"game_over\": %s, \"player_score\": %d, \"checksum\": \"%016llx\"}\n",
+                opt.replay.c_str(), static_cast<unsigned long long>(replay.getSeed()), frameNs.size(),
+                scene->GetAquarium()->getWorkerThreads(), total / frameNs.size(), Percentile(frameNs, 0.50),
+                Percentile(frameNs, 0.99), scene->IsGameOver() ? "true" : "false", scene->GetPlayer()->getScore(),
+                StateChecksum(scene->GetAquarium()->getCreatures()));
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    if (!ParseOptions(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: %s [--creatures N] [--ticks M] [--warmup K] [--seed S] [--width W] [--height H] [--threads T] [--level-target S] [--spawn-budget B] [--snapshot FILE]"
+                             " [--view-width W --view-height H] [--activity-radius R] [--flocking 1] [--solver-iterations I] [--island-sleep 1]\n"
+                             "       %s --replay FILE [--threads T]\n", argv[0], argv[0]);
+        return 1;
+    }
+    if (!opt.replay.empty()) return RunReplay(opt);
+
+    auto spriteManager = std::make_shared<AquariumSpriteManager>();
+    auto makeAquarium = [&]() {
+        auto aquarium = std::make_shared<Aquarium>(opt.width, opt.height, spriteManager);
+        aquarium->setSeed(opt.seed);
+        if (opt.threads > 0) aquarium->setWorkerThreads(opt.threads);
+        if (opt.spawnBudget >= 0) aquarium->setSpawnBudget(opt.spawnBudget);
+        aquarium->setActivityRadii(opt.activityRadius, 4.0f * opt.activityRadius);
+        aquarium->setFlocking(opt.flocking != 0);
+        if (opt.solverIterations > 0) aquarium->setSolverIterations(opt.solverIterations);
+        aquarium->setIslandSleep(opt.islandSleep != 0);
+        if (opt.levelTarget > 0) {
+            aquarium->addAquariumLevel(std::make_shared<BenchLevel>(0, opt.creatures, opt.levelTarget));
+            aquarium->addAquariumLevel(std::make_shared<BenchLevel>(1, opt.creatures / 2, opt.levelTarget));
+        } else {
+            aquarium->addAquariumLevel(std::make_shared<BenchLevel>(0, opt.creatures, INT_MAX));
+        }
+        return aquarium;
+    };
+    // the player sweeps the tank diagonally and never runs out of lives
+    auto makePlayer = [&]() {
+        auto player = std::make_shared<PlayerCreature>(opt.width / 2.0f, opt.height / 2.0f, 5,
+                                                       spriteManager->GetSprite(AquariumCreatureType::NPCreature));
+        player->setBounds(opt.width - 20, opt.height - 20);
+        player->setDirection(1, 1);
+        player->setLives(INT_MAX);
+        return player;
+    };
+
+    auto aquarium = makeAquarium();
+    aquarium->Repopulate();
+    aquarium->flushSpawns();
+    auto player = makePlayer();
+
+    AquariumGameScene scene(player, aquarium, "bench");
+    unsigned long long events = 0;
+    scene.GetEvents().subscribe([&events](const GameEvent&) { ++events; });
+
+    for (int t = 0; t < opt.warmup; ++t) {
+        player->update();
+        scene.Tick();
+        scene.GetEvents().dispatch();
+    }
+    events = 0;
+
+    // draws are timed outside the tick, through the camera the game uses
+    bool timeDraws = opt.viewWidth > 0 && opt.viewHeight > 0;
+    AquariumCamera camera;
+    camera.setViewport(opt.viewWidth, opt.viewHeight);
+    camera.setWorld(opt.width, opt.height);
+    double drawNs = 0.0;
+    long long drawn = 0;
+    long long awake = 0;
+    long long contacts = 0;
+    long long islands = 0;
+    long long sleeping = 0;
+
+    std::vector<double> tickNs;
+    tickNs.reserve(opt.ticks);
+    int levelChanges = 0;
+    unsigned long long levelChangeAllocations = 0;
+    int poolGrowthsBefore = aquarium->getPoolGrowths();
+    unsigned long long allocationsBefore = g_allocations.load();
+    for (int t = 0; t < opt.ticks; ++t) {
+        int level = aquarium->getLevelIndex();
+        unsigned long long tickAllocations = g_allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        player->update();
+        scene.Tick();
+        scene.GetEvents().dispatch();
+        auto end = std::chrono::steady_clock::now();
+        tickNs.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        awake += aquarium->getAwakeCount();
+        contacts += aquarium->getContactCount();
+        islands += aquarium->getIslandCount();
+        sleeping += aquarium->getSleepingCount();
+        if (timeDraws) {
+            camera.follow(player->getX(), player->getY());
+            start = std::chrono::steady_clock::now();
+            aquarium->draw(1.0f, camera.getView());
+            drawNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            drawn += aquarium->getDrawnCount();
+        }
+        if (aquarium->getLevelIndex() != level) {
+            ++levelChanges;
+            levelChangeAllocations += g_allocations.load() - tickAllocations;
+        }
+    }
+    unsigned long long allocations = g_allocations.load() - allocationsBefore;
+
+    double total = 0.0;
+    for (double ns : tickNs) total += ns;
+
+    std::printf("{\"creatures\": %d, \"ticks\": %d, \"warmup\": %d, \"seed\": %u, \"width\": %d, \"height\": %d, "
+                "\"threads\": %d, \"spawn_budget\": %d, \"ns_per_tick\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, \"max_ns\": %.1f, "
+                "\"allocations_per_tick\": %.3f, \"level_changes\": %d, \"allocations_at_level_changes\": %llu, "
+                "\"pool_growths\": %d, \"awake_per_tick\": %.1f, \"contacts_per_tick\": %.1f, \"islands_per_tick\": %.1f, \"sleeping_per_tick\": %.1f, \"draw_ns\": %.1f, \"drawn_per_draw\": %.1f, \"events_per_tick\": %.2f, \"events_dropped\": %lu, \"final_population\": %d, \"player_score\": %d, \"checksum\": \"%016llx\"}\n",
+                opt.creatures, opt.ticks, opt.warmup, opt.seed, opt.width, opt.height,
+                aquarium->getWorkerThreads(), aquarium->getSpawnBudget(), total / opt.ticks, Percentile(tickNs, 0.50), Percentile(tickNs, 0.99),
+                *std::max_element(tickNs.begin(), tickNs.end()),
+                static_cast<double>(allocations) / opt.ticks, levelChanges, levelChangeAllocations,
+                aquarium->getPoolGrowths() - poolGrowthsBefore, static_cast<double>(awake) / opt.ticks,
+                static_cast<double>(contacts) / opt.ticks, static_cast<double>(islands) / opt.ticks, static_cast<double>(sleeping) / opt.ticks, drawNs / opt.ticks,
+                static_cast<double>(drawn) / opt.ticks, static_cast<double>(events) / opt.ticks,
+                scene.GetEvents().dropped(), aquarium->getCreatureCount(), player->getScore(),
+                StateChecksum(aquarium->getCreatures()));
+    if (opt.snapshot.empty()) return 0;
+
+    // restore into a tank with the same levels and compare the state
+    auto start = std::chrono::steady_clock::now();
+    bool saved = scene.SaveSnapshot(opt.snapshot);
+    double saveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    auto restored = makeAquarium();
+    AquariumGameScene restoredScene(makePlayer(), restored, "restored");
+    SnapshotReader reader;
+    start = std::chrono::steady_clock::now();
+    bool read = saved && reader.load(opt.snapshot);
+    auto readEnd = std::chrono::steady_clock::now();
+    bool loaded = read && restoredScene.LoadSnapshot(reader);
+    double readMs = std::chrono::duration<double, std::milli>(readEnd - start).count();
+    double restoreMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - readEnd).count();
+
+    bool matches = loaded && StateChecksum(restored->getCreatures()) == StateChecksum(aquarium->getCreatures()) &&
+                   restoredScene.GetPlayer()->getScore() == player->getScore() &&
+                   restored->getLevelIndex() == aquarium->getLevelIndex();
+    // one more tick on both sides must agree too, generator and queues included
+    if (matches) {
+        player->update();
+        scene.Tick();
+        restoredScene.GetPlayer()->update();
+        restoredScene.Tick();
+        matches = StateChecksum(restored->getCreatures()) == StateChecksum(aquarium->getCreatures());
+    }
+    std::printf("{\"snapshot\": \"%s\", \"bytes\": %zu, \"creatures\": %d, \"save_ms\": %.3f, \"read_ms\": %.3f, "
+                "\"restore_ms\": %.3f, \"matches\": %s}\n",
+                opt.snapshot.c_str(), reader.size(), restored->getCreatureCount(), saveMs, readMs, restoreMs,
+                matches ? "true" : "false");
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// Benchmark for the flocking pass.
+//
+// Runs Aquarium::update() with flocking on for N mixed fish over M ticks and
+// checks the p99 tick against the 60 Hz frame budget: a world tick runs
+// inside one frame, however rarely it comes. Then steers the final state once
+// with neighbours from the spatial grid and once with an all-pairs scan, times
+// both on one thread and checks that they agree. Exits non-zero if the budget
+// is missed or the two scans disagree; --no-budget 1 drops the timing check on
+// hosts too slow or loaded to meet it, and the report says so.
+//
+//   flock-bench [--creatures N] [--ticks M] [--warmup K] [--seed S]
+//               [--width W] [--height H] [--threads T] [--no-budget 1]
+
+#include "Aquarium.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const double kFrameBudgetNs = 1e9 / 60.0;
+// grid and all-pairs sum the same neighbours in a different order
+static const float kHeadingTolerance = 1e-4f;
+
+// Same mix as the aquarium-bench level: half small fish, then bigger, fast and armored
+class FlockLevel : public AquariumLevel {
+public:
+    explicit FlockLevel(int population) : AquariumLevel(0, INT_MAX) {
+        int bigger = population / 4;
+        int fast = population / 6;
+        int armored = population / 12;
+        int npc = population - bigger - fast - armored;
+        m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, npc));
+        m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, bigger));
+        m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::FastFish, fast));
+        m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::ArmoredFish, armored));
+    }
+};
+
+static double Percentile(std::vector<double> samples, double p) {
+    size_t k = static_cast<size_t>(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    return samples[k];
+}
+
+int main(int argc, char** argv) {
+    int creatures = 10000;
+    int ticks = 600;
+    int warmup = 60;
+    unsigned seed = 1;
+    int width = 4096;
+    int height = 3072;
+    int threads = 0;
+    bool gateBudget = true;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        int value = std::atoi(argv[i + 1]);
+        if (!std::strcmp(argv[i], "--creatures")) creatures = value;
+        else if (!std::strcmp(argv[i], "--ticks")) ticks = value;
+        else if (!std::strcmp(argv[i], "--warmup")) warmup = value;
+        else if (!std::strcmp(argv[i], "--seed")) seed = static_cast<unsigned>(value);
+        else if (!std::strcmp(argv[i], "--width")) width = value;
+        else if (!std::strcmp(argv[i], "--height")) height = value;
+        else if (!std::strcmp(argv[i], "--threads")) threads = value;
+        else if (!std::strcmp(argv[i], "--no-budget")) gateBudget = value == 0;
+    }
+    if (creatures <= 0 || ticks <= 0 || width <= 0 || height <= 0) {
+        std::fprintf(stderr, "usage: %s [--creatures N] [--ticks M] [--warmup K] [--seed S] [--width W] [--height H] [--threads T] [--no-budget 1]\n", argv[0]);
+        return 1;
+    }
+
+    auto spriteManager = std::make_shared<AquariumSpriteManager>();
+    Aquarium aquarium(width, height, spriteManager);
+    aquarium.setSeed(seed);
+    if (threads > 0) aquarium.setWorkerThreads(threads);
+    aquarium.setFlocking(true);
+    aquarium.addAquariumLevel(std::make_shared<FlockLevel>(creatures));
+    aquarium.Repopulate();
+    aquarium.flushSpawns();
+
+    for (int t = 0; t < warmup; ++t) aquarium.update();
+    std::vector<double> tickNs;
+    tickNs.reserve(ticks);
+    FrameProfiler &profiler = FrameProfiler::instance();
+    for (int t = 0; t < ticks; ++t) {
+        profiler.beginFrame();
+        auto start = std::chrono::steady_clock::now();
+        aquarium.update();
+        tickNs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    double total = 0.0;
+    for (double ns : tickNs) total += ns;
+    double p99 = Percentile(tickNs, 0.99);
+    profiler.beginFrame();
+    // averages over the profiler's last frames
+    double steerMs = profiler.zoneStats(profiler.zone("aquarium.steer")).avgMs;
+    double moveMs = profiler.zoneStats(profiler.zone("aquarium.move")).avgMs;
+    double collideMs = profiler.zoneStats(profiler.zone("aquarium.collide")).avgMs;
+
+    // one steering pass over the final state, both ways, on this thread
+    const AquariumCreatureStore &s = aquarium.getCreatures();
+    size_t n = s.size();
+    std::vector<float> gridDx(n), gridDy(n), pairsDx(n), pairsDy(n);
+    long long gridVisits = 0;
+    auto start = std::chrono::steady_clock::now();
+    AquariumSpatialGrid grid;
+    grid.rebuild(s, width, height);
+    for (size_t i = 0; i < n; ++i) {
+        AquariumFlockSteering steer(s, static_cast<int>(i));
+        float r = steer.radius();
+        grid.forEachInBox(s.x[i] - r, s.y[i] - r, s.x[i] + r, s.y[i] + r, [&](int j) {
+            steer.add(j);
+            ++gridVisits;
+        });
+        steer.result(gridDx[i], gridDy[i]);
+    }
+    double gridNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        AquariumFlockSteering steer(s, static_cast<int>(i));
+        for (size_t j = 0; j < n; ++j) steer.add(static_cast<int>(j));
+        steer.result(pairsDx[i], pairsDy[i]);
+    }
+    double pairsNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    float maxError = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        maxError = std::max(maxError, std::max(std::fabs(gridDx[i] - pairsDx[i]), std::fabs(gridDy[i] - pairsDy[i])));
+    }
+    bool withinBudget = p99 < kFrameBudgetNs;
+    bool matches = maxError <= kHeadingTolerance;
+
+    std::printf("{\"creatures\": %zu, \"ticks\": %d, \"warmup\": %d, \"seed\": %u, \"width\": %d, \"height\": %d, "
+                "\"threads\": %d, \"ns_per_tick\": %.1f, \"p99_ns\": %.1f, \"max_ns\": %.1f, \"budget_ns\": %.1f, "
+                "\"within_budget\": %s, \"budget_gated\": %s, \"steer_ms\": %.3f, \"move_ms\": %.3f, \"collide_ms\": %.3f, \"grid_steer_ns\": %.1f, \"all_pairs_steer_ns\": %.1f, "
+                "\"neighbours_per_fish\": %.1f, \"max_heading_error\": %.2e, \"matches_all_pairs\": %s}\n",
+                n, ticks, warmup, seed, width, height, aquarium.getWorkerThreads(), total / ticks, p99,
+                *std::max_element(tickNs.begin(), tickNs.end()), kFrameBudgetNs, withinBudget ? "true" : "false",
+                gateBudget ? "true" : "false",
+                steerMs, moveMs, collideMs,
+                gridNs, pairsNs, n ? static_cast<double>(gridVisits) / n : 0.0, maxError, matches ? "true" : "false");
+    return matches && (withinBudget || !gateBudget) ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+// Microbenchmark for the creature move kernels.
+//
+// Moves the same N fish for M steps with the per-object virtual move() of the
+// fish classes and with every AquariumMoveKernel the CPU supports, then checks
+// that each kernel ends in exactly the state the per-object methods reach.
+//
+//   kernel-bench [--creatures N] [--steps M] [--seed S]
+
+#include "Aquarium.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const int kWidth = 1024;
+static const int kHeight = 768;
+
+static std::unique_ptr<NPCreature> MakeFish(AquariumCreatureType type, float x, float y, int speed, float dx, float dy) {
+    switch (type) {
+        case AquariumCreatureType::BiggerFish:  return std::make_unique<BiggerFish>(x, y, speed, dx, dy, nullptr);
+        case AquariumCreatureType::FastFish:    return std::make_unique<FastFish>(x, y, speed, dx, dy, nullptr);
+        case AquariumCreatureType::ArmoredFish: return std::make_unique<ArmoredFish>(x, y, speed, dx, dy, nullptr);
+        default:                                return std::make_unique<NPCreature>(x, y, speed, dx, dy, nullptr);
+    }
+}
+
+static bool SameBits(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+int main(int argc, char** argv) {
+    int creatures = 10000;
+    int steps = 1000;
+    unsigned seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--creatures")) creatures = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--steps")) steps = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--seed")) seed = static_cast<unsigned>(std::atoi(argv[i + 1]));
+    }
+    std::srand(seed);
+
+    // same fish as heap objects and as store rows
+    std::vector<std::unique_ptr<NPCreature>> objects;
+    AquariumCreatureStore initial;
+    for (int i = 0; i < creatures; ++i) {
+        auto type = static_cast<AquariumCreatureType>(i % kAquariumCreatureTypeCount);
+        int x = std::rand() % kWidth;
+        int y = std::rand() % kHeight;
+        int speed = 1 + std::rand() % 25;
+        float dx = static_cast<float>(std::rand() % 3 - 1);
+        float dy = static_cast<float>(std::rand() % 3 - 1);
+        objects.push_back(MakeFish(type, x, y, speed, dx, dy));
+        objects.back()->setBounds(kWidth - 20, kHeight - 20);
+        initial.add(*objects.back(), 0);
+    }
+    const float maxX = static_cast<float>(kWidth - 20);
+    const float maxY = static_cast<float>(kHeight - 20);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        for (auto &fish : objects) fish->move();
+    }
+    double objectNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    AquariumCreatureStore reference = initial;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        reference.x[i] = objects[i]->getX();
+        reference.y[i] = objects[i]->getY();
+        reference.dx[i] = objects[i]->getDx();
+        reference.dy[i] = objects[i]->getDy();
+    }
+    double perStep = static_cast<double>(creatures) * steps;
+    std::printf("{\"kernel\": \"per-object\", \"creatures\": %d, \"steps\": %d, \"ns_per_creature\": %.3f}\n",
+                creatures, steps, objectNs / perStep);
+
+    bool allMatch = true;
+    for (auto kernel : {AquariumMoveKernel::SCALAR, AquariumMoveKernel::SSE, AquariumMoveKernel::AVX2}) {
+        if (!AquariumMoveKernelSupported(kernel)) continue;
+        AquariumCreatureStore store = initial;
+        start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; ++s) {
+            AquariumMoveCreatures(store, 0, store.size(), maxX, maxY, kernel);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        bool match = SameBits(store.x, reference.x) && SameBits(store.y, reference.y) &&
+                     SameBits(store.dx, reference.dx) && SameBits(store.dy, reference.dy);
+        allMatch = allMatch && match;
+        std::printf("{\"kernel\": \"%s\", \"creatures\": %d, \"steps\": %d, \"ns_per_creature\": %.3f, "
+                    "\"speedup_vs_per_object\": %.2f, \"matches_per_object\": %s}\n",
+                    AquariumMoveKernelToString(kernel).c_str(), creatures, steps, ns / perStep,
+                    objectNs / ns, match ? "true" : "false");
+    }
+    return allMatch ? 0 : 1;
+}
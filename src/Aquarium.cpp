@@ -1,6 +1,7 @@
 #include "Aquarium.h"
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
 
 void Creature::setDirection(float dx, float dy) { m_dx = dx; m_dy = dy; }
 void Creature::setX(float x) { m_x = x; }
@@ -17,11 +18,35 @@ std::string AquariumCreatureTypeToString(AquariumCreatureType t) {
     }
 }
 
+AquariumFlockSteering::AquariumFlockSteering(const AquariumCreatureStore& s, int self)
+    : m_store(s), m_rules(AquariumFlockingRulesFor(s.type[self])), m_type(s.type[self]),
+      m_sizeClass(AquariumCreatureSizeClass(s.type[self])), m_self(self), m_x(s.x[self]), m_y(s.y[self]),
+      m_selfRadius(s.radius[self]), m_radius2(m_rules.radius * m_rules.radius), m_invRadius(1.0f / m_rules.radius) {}
+
+void AquariumFlockSteering::result(float& dx, float& dy) const {
+    float headingX = m_store.dx[m_self];
+    float headingY = m_store.dy[m_self];
+    float nx = headingX + m_awayX;
+    float ny = headingY + m_awayY;
+    if (m_school > 0) {
+        float share = 1.0f / m_school;
+        nx += (m_headingX * share - headingX) * m_rules.alignment + m_centreX * share / m_rules.radius * m_rules.cohesion;
+        ny += (m_headingY * share - headingY) * m_rules.alignment + m_centreY * share / m_rules.radius * m_rules.cohesion;
+    }
+    float length = std::sqrt(nx * nx + ny * ny);
+    if (length < 1e-6f) {
+        dx = headingX;
+        dy = headingY;
+        return;
+    }
+    dx = nx / length;
+    dy = ny / length;
+}
+
 
 PlayerCreature::PlayerCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-    : Creature(x, y, speed, 10.0f, 1, sprite) 
+    : Creature(x, y, speed, 10.0f, 1, sprite), m_prevX(x), m_prevY(y)
 {
-    m_flashSprite = std::make_shared<GameSprite>("white-fish.png", 70, 70);
 }
 
 void PlayerCreature::setDirection(float dx, float dy) {
@@ -43,24 +68,29 @@ void PlayerCreature::reduceDamageDebounce() {
 
 void PlayerCreature::update() {
     reduceDamageDebounce();
+    m_prevX = m_x;
+    m_prevY = m_y;
     move();
     if (m_flashFrames > 0) --m_flashFrames;
 }
 
 void PlayerCreature::draw() const {
-    if (!m_sprite) return;
+    drawInterpolated(1.0f);
+}
 
-    m_sprite->setFlipped(m_flipped);
+void PlayerCreature::drawInterpolated(float alpha) const {
+    if (!m_sprite) return;
 
+    float x = getDrawX(alpha);
+    float y = getDrawY(alpha);
     if (m_flashFrames > 0 && m_flashSprite) {
-        m_flashSprite->setFlipped(m_flipped);
         ofPushStyle();
         ofEnableBlendMode(OF_BLENDMODE_ADD);
-        m_flashSprite->draw(m_x, m_y);
+        m_flashSprite->draw(x, y, m_flipped);
         ofDisableBlendMode();
         ofPopStyle();
     } else {
-        m_sprite->draw(m_x, m_y);
+        m_sprite->draw(x, y, m_flipped);
     }
 }
 
@@ -71,6 +101,7 @@ void PlayerCreature::changeSpeed(int speed) {
 void PlayerCreature::loseLife(int debounce) {
     if (m_damage_debounce <= 0) {
         if (m_lives > 0) --m_lives;
+        ++m_statsRevision;
         m_damage_debounce = debounce;
         ofLogNotice() << "Player lost a life! Lives remaining: " << m_lives;
         startFlash();
@@ -79,6 +110,7 @@ void PlayerCreature::loseLife(int debounce) {
 
 void PlayerCreature::increasePower(int value) {
     m_power += value;
+    ++m_statsRevision;
     m_collisionRadius += 3.0f;
     m_speed += 1.0f;
 }
@@ -88,11 +120,10 @@ void PlayerCreature::startFlash() {
 }
 
 
-NPCreature::NPCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-    : Creature(x, y, speed, 30.0f, 1, sprite)
+NPCreature::NPCreature(float x, float y, int speed, float dx, float dy, std::shared_ptr<GameSprite> sprite)
+    : Creature(x, y, speed, kBaseRadius, 1, sprite)
 {
-    m_dx = (rand() % 3 - 1);
-    m_dy = (rand() % 3 - 1);
+    setDirection(dx, dy);
     normalize();
     m_creatureType = AquariumCreatureType::NPCreature;
     m_value = 1;
@@ -101,17 +132,16 @@ NPCreature::NPCreature(float x, float y, int speed, std::shared_ptr<GameSprite>
 void NPCreature::move() {
     m_x += m_dx * m_speed;
     m_y += m_dy * m_speed;
-    if (m_sprite) m_sprite->setFlipped(m_dx < 0);
     bounce();
 }
 
 void NPCreature::draw() const {
-    if (m_sprite) m_sprite->draw(m_x, m_y);
+    if (m_sprite) m_sprite->draw(m_x, m_y, m_dx < 0);
 }
 
 // ---- BiggerFish
-BiggerFish::BiggerFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-    : NPCreature(x, y, speed, sprite)
+BiggerFish::BiggerFish(float x, float y, int speed, float dx, float dy, std::shared_ptr<GameSprite> sprite)
+    : NPCreature(x, y, speed, dx, dy, sprite)
 {
     m_value = 5;
     m_creatureType = AquariumCreatureType::BiggerFish;
@@ -121,17 +151,16 @@ BiggerFish::BiggerFish(float x, float y, int speed, std::shared_ptr<GameSprite>
 void BiggerFish::move() {
     m_x += m_dx * (m_speed * 0.5f);
     m_y += m_dy * (m_speed * 0.5f);
-    if (m_sprite) m_sprite->setFlipped(m_dx < 0);
     bounce();
 }
 
 void BiggerFish::draw() const {
-    if (m_sprite) m_sprite->draw(m_x, m_y);
+    if (m_sprite) m_sprite->draw(m_x, m_y, m_dx < 0);
 }
 
 //FastFish
-FastFish::FastFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-    : NPCreature(x, y, speed, sprite)
+FastFish::FastFish(float x, float y, int speed, float dx, float dy, std::shared_ptr<GameSprite> sprite)
+    : NPCreature(x, y, speed, dx, dy, sprite)
 {
     m_creatureType = AquariumCreatureType::FastFish;
     m_speed = std::max(1, speed * 2);
@@ -140,17 +169,16 @@ FastFish::FastFish(float x, float y, int speed, std::shared_ptr<GameSprite> spri
 void FastFish::move() {
     m_x += m_dx * m_speed;
     m_y += m_dy * m_speed;
-    if (m_sprite) m_sprite->setFlipped(m_dx < 0);
     bounce();
 }
 
 void FastFish::draw() const {
-    if (m_sprite) m_sprite->draw(m_x, m_y);
+    if (m_sprite) m_sprite->draw(m_x, m_y, m_dx < 0);
 }
 
 //ArmoredFish
-ArmoredFish::ArmoredFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-    : NPCreature(x, y, speed, sprite)
+ArmoredFish::ArmoredFish(float x, float y, int speed, float dx, float dy, std::shared_ptr<GameSprite> sprite)
+    : NPCreature(x, y, speed, dx, dy, sprite)
 {
     m_creatureType = AquariumCreatureType::ArmoredFish;
     m_speed = std::max(1, int(speed * 0.5f));
@@ -160,36 +188,60 @@ ArmoredFish::ArmoredFish(float x, float y, int speed, std::shared_ptr<GameSprite
 void ArmoredFish::move() {
     m_x += m_dx * m_speed;
     m_y += m_dy * m_speed;
-    if (m_sprite) m_sprite->setFlipped(m_dx < 0);
     bounce();
 }
 
 void ArmoredFish::draw() const {
-    if (m_sprite) m_sprite->draw(m_x, m_y);
+    if (m_sprite) m_sprite->draw(m_x, m_y, m_dx < 0);
 }
 
 
 AquariumSpriteManager::AquariumSpriteManager() {
-    m_npc_fish     = std::make_shared<GameSprite>("base-fish.png",    70, 70);
-    m_big_fish     = std::make_shared<GameSprite>("bigger-fish.png", 120,120);
-    m_fast_fish    = std::make_shared<GameSprite>("fast-fish.png",    70, 70);
-    m_armored_fish = std::make_shared<GameSprite>("armored-fish.png", 90, 90);
+    load(nullptr);
+}
+
+AquariumSpriteManager::AquariumSpriteManager(AssetLoader& loader) {
+    load(&loader);
+}
+
+// Without a loader every sprite is read from disk right here
+void AquariumSpriteManager::load(AssetLoader* loader) {
+    auto sprite = [loader](const std::string& path, int w, int h) {
+        return loader ? loader->queueSprite(path, w, h) : std::make_shared<GameSprite>(path, w, h);
+    };
+    m_npc_fish     = sprite("base-fish.png",    70, 70);
+    m_big_fish     = sprite("bigger-fish.png", 120,120);
+    m_fast_fish    = sprite("fast-fish.png",    70, 70);
+    m_armored_fish = sprite("armored-fish.png", 90, 90);
+    m_flash_fish   = sprite("white-fish.png",   70, 70);
+    m_speed_powerup = sprite("speed_powerup.png", 40, 40);
+    m_power_powerup = sprite("power_powerup.png", 40, 40);
+    m_size_powerup  = sprite("size_powerup.png",  40, 40);
 }
 
 std::shared_ptr<GameSprite> AquariumSpriteManager::GetSprite(AquariumCreatureType t) {
     switch (t) {
-        case AquariumCreatureType::NPCreature:  return std::make_shared<GameSprite>(*m_npc_fish);
-        case AquariumCreatureType::BiggerFish:  return std::make_shared<GameSprite>(*m_big_fish);
-        case AquariumCreatureType::FastFish:    return std::make_shared<GameSprite>(*m_fast_fish);
-        case AquariumCreatureType::ArmoredFish: return std::make_shared<GameSprite>(*m_armored_fish);
+        case AquariumCreatureType::NPCreature:  return m_npc_fish;
+        case AquariumCreatureType::BiggerFish:  return m_big_fish;
+        case AquariumCreatureType::FastFish:    return m_fast_fish;
+        case AquariumCreatureType::ArmoredFish: return m_armored_fish;
         default:                                return nullptr;
     }
 }
 
+std::shared_ptr<GameSprite> AquariumSpriteManager::GetPowerUpSprite(PowerUp::Type t) {
+    switch (t) {
+        case PowerUp::Type::SPEED: return m_speed_powerup;
+        case PowerUp::Type::POWER: return m_power_powerup;
+        case PowerUp::Type::SIZE:  return m_size_powerup;
+        default:                   return nullptr;
+    }
+}
+
 
 void PowerUp::move() {
     m_y += 1.0f;
-    if (m_y > ofGetHeight()) m_y = 0;
+    if (m_y > m_height) m_y = 0;
 }
 
 void PowerUp::draw() const {
@@ -219,9 +271,15 @@ bool AquariumLevel::isCompleted() {
     return m_level_score >= m_targetScore;
 }
 
+int AquariumLevel::getMaxPopulation() const {
+    int total = 0;
+    for (const auto &node : m_levelPopulation) total += node->population;
+    return total;
+}
+
 // Level repopulate helpers
-static std::vector<AquariumCreatureType> RepopulateFromNodes(std::vector<std::shared_ptr<AquariumLevelPopulationNode>> &nodes) {
-    std::vector<AquariumCreatureType> out;
+static void RepopulateFromNodes(std::vector<std::shared_ptr<AquariumLevelPopulationNode>> &nodes,
+                                std::vector<AquariumCreatureType> &out) {
     for (auto &node : nodes) {
         int need = node->population - node->currentPopulation;
         if (need > 0) {
@@ -229,132 +287,818 @@ static std::vector<AquariumCreatureType> RepopulateFromNodes(std::vector<std::sh
             node->currentPopulation += need;
         }
     }
-    return out;
 }
 
-std::vector<AquariumCreatureType> AquariumLevel::Repopulate() {
-    std::vector<AquariumCreatureType> out;
-    for (auto &node : m_levelPopulation) {
-        int need = node->population - node->currentPopulation;
-        if (need > 0) {
-            out.insert(out.end(), need, node->creatureType);
-            node->currentPopulation += need;
-        }
+void AquariumLevel::Repopulate(std::vector<AquariumCreatureType>& out) {
+    RepopulateFromNodes(m_levelPopulation, out);
+}
+
+
+// ---- Creature store
+CreatureHandle AquariumCreatureStore::add(const NPCreature& creature, int sprite, int bornTick) {
+    x.push_back(creature.getX());
+    y.push_back(creature.getY());
+    prevX.push_back(creature.getX());
+    prevY.push_back(creature.getY());
+    dx.push_back(creature.getDx());
+    dy.push_back(creature.getDy());
+    // the type's factor is applied once here, the move kernels never look at the type
+    step.push_back(creature.getSpeed() * AquariumCreatureSpeedScale(creature.GetType()));
+    radius.push_back(creature.getCollisionRadius());
+    value.push_back(creature.getValue());
+    type.push_back(creature.GetType());
+    spriteId.push_back(sprite);
+    born.push_back(bornTick);
+    rest.push_back(0);
+
+    int slot = acquireSlot();
+    m_slotRow[slot] = static_cast<int>(size()) - 1;
+    m_rowSlot.push_back(slot);
+    return CreatureHandle{slot, m_slotGeneration[slot]};
+}
+
+int AquariumCreatureStore::acquireSlot() {
+    if (!m_freeSlots.empty()) {
+        int slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        return slot;
+    }
+    m_slotRow.push_back(-1);
+    m_slotGeneration.push_back(0);
+    return static_cast<int>(m_slotRow.size()) - 1;
+}
+
+void AquariumCreatureStore::rebuildSlots() {
+    // free every slot, newest generation, then hand them out in row order
+    m_freeSlots.clear();
+    for (size_t slot = m_slotRow.size(); slot-- > 0;) {
+        m_slotRow[slot] = -1;
+        ++m_slotGeneration[slot];
+        m_freeSlots.push_back(static_cast<int>(slot));
+    }
+    m_rowSlot.resize(size());
+    for (size_t row = 0; row < size(); ++row) {
+        int slot = acquireSlot();
+        m_slotRow[slot] = static_cast<int>(row);
+        m_rowSlot[row] = slot;
+    }
+}
+
+void AquariumCreatureStore::remove(CreatureHandle h) {
+    int row = rowOf(h);
+    if (row < 0) return;
+    // swap and pop: the last row fills the hole and its slot follows it
+    size_t last = size() - 1;
+    if (static_cast<size_t>(row) != last) {
+        forEachColumn([row, last](auto &column) { column[row] = column[last]; });
+        m_slotRow[m_rowSlot[row]] = row;
+    }
+    forEachColumn([](auto &column) { column.pop_back(); });
+    m_slotRow[h.index] = -1;
+    ++m_slotGeneration[h.index];
+    m_freeSlots.push_back(h.index);
+}
+
+void AquariumCreatureStore::clear() {
+    for (int slot : m_rowSlot) {
+        m_slotRow[slot] = -1;
+        ++m_slotGeneration[slot];
+        m_freeSlots.push_back(slot);
     }
-    return out;
+    forEachColumn([](auto &column) { column.clear(); });
 }
 
+void AquariumCreatureStore::reserve(size_t n) {
+    forEachColumn([n](auto &column) { column.reserve(n); });
+    m_slotRow.reserve(n);
+    m_slotGeneration.reserve(n);
+    m_freeSlots.reserve(n);
+}
+
+
+// ---- Spatial grid
+void AquariumSpatialGrid::rebuild(const AquariumCreatureStore& creatures, int width, int height) {
+    float maxRadius = 1.0f;
+    for (float r : creatures.radius) maxRadius = std::max(maxRadius, r);
+    m_cellSize = 2.0f * maxRadius;
+    m_cols = std::max(1, static_cast<int>(std::ceil(width / m_cellSize)));
+    m_rows = std::max(1, static_cast<int>(std::ceil(height / m_cellSize)));
+
+    // counting sort of creature indices by cell
+    m_cellStart.assign(m_cols * m_rows + 1, 0);
+    m_creatureCell.resize(creatures.size());
+    for (size_t i = 0; i < creatures.size(); ++i) {
+        m_creatureCell[i] = cellOf(creatures.x[i], creatures.y[i]);
+        ++m_cellStart[m_creatureCell[i] + 1];
+    }
+    for (size_t c = 1; c < m_cellStart.size(); ++c) m_cellStart[c] += m_cellStart[c - 1];
+
+    m_cellEntries.resize(creatures.size());
+    for (size_t i = 0; i < creatures.size(); ++i) {
+        m_cellEntries[m_cellStart[m_creatureCell[i]]++] = static_cast<int>(i);
+    }
+    // the scatter advanced every start to the end of its cell, shift them back
+    for (size_t c = m_cellStart.size() - 1; c > 0; --c) m_cellStart[c] = m_cellStart[c - 1];
+    m_cellStart[0] = 0;
+}
+
+void AquariumSpatialGrid::reserve(size_t creatures, int width, int height, float minRadius) {
+    // the smallest cells rebuild() picks, when only the smallest fish are left
+    float cellSize = 2.0f * std::max(1.0f, minRadius);
+    size_t cells = static_cast<size_t>(std::max(1, static_cast<int>(std::ceil(width / cellSize)))) *
+                   static_cast<size_t>(std::max(1, static_cast<int>(std::ceil(height / cellSize))));
+    if (cells + 1 > m_cellStart.capacity()) m_cellStart.reserve(cells + 1);
+    if (creatures > m_creatureCell.capacity()) m_creatureCell.reserve(creatures);
+    if (creatures > m_cellEntries.capacity()) m_cellEntries.reserve(creatures);
+}
+
+int AquariumSpatialGrid::cellOf(float x, float y) const {
+    // creatures pushed past the walls still land in the border cells
+    int cx = std::min(std::max(static_cast<int>(x / m_cellSize), 0), m_cols - 1);
+    int cy = std::min(std::max(static_cast<int>(y / m_cellSize), 0), m_rows - 1);
+    return cy * m_cols + cx;
+}
+
+
+
+// creatures per work item for the parallel loops in update()
+static const size_t kMoveGrain = 1024;
+static const size_t kCollisionBand = 256;
+static const size_t kSteerGrain = 256;
+static const size_t kIslandGrain = 64;
+static const size_t kContactGrain = 1024;
+// contacts per fish the contact scratch is reserved for; only a tank packed
+// tighter than this grows it
+static const size_t kContactsPerFish = 8;
 
 Aquarium::Aquarium(int width, int height, std::shared_ptr<AquariumSpriteManager> spriteManager)
     : m_width(width), m_height(height), m_sprite_manager(std::move(spriteManager)) {}
 
-void Aquarium::addCreature(std::shared_ptr<Creature> creature) {
-    creature->setBounds(m_width - 20, m_height - 20);
-    m_creatures.push_back(std::move(creature));
+CreatureHandle Aquarium::addCreature(const NPCreature& creature) {
+    if (m_creatures.size() == m_creatures.capacity()) ++m_poolGrowths;
+    m_gridDirty = true;
+    return m_creatures.add(creature, spriteIdFor(creature.GetType()), m_tick);
+}
+
+// Creatures of one type share the manager's sprite, flipped per draw from their direction
+int Aquarium::spriteIdFor(AquariumCreatureType type) {
+    int id = static_cast<int>(type);
+    if (static_cast<size_t>(id) >= m_sprites.size()) m_sprites.resize(id + 1);
+    if (!m_sprites[id] && m_sprite_manager) m_sprites[id] = m_sprite_manager->GetSprite(type);
+    return id;
 }
 
 void Aquarium::addAquariumLevel(std::shared_ptr<AquariumLevel> level) {
-    if (level) m_aquariumlevels.push_back(std::move(level));
+    if (!level) return;
+    size_t population = static_cast<size_t>(level->getMaxPopulation());
+    if (population > m_creatures.capacity()) m_creatures.reserve(population);
+    if (population > m_spawnTypes.capacity()) m_spawnTypes.reserve(population);
+    if (population > m_spawnQueue.capacity()) m_spawnQueue.reserve(population);
+    if (population > m_nextLevelSpawns.capacity()) m_nextLevelSpawns.reserve(population);
+    if (population > m_stepScale.capacity()) m_stepScale.reserve(population);
+    if (population > m_steerDx.capacity()) m_steerDx.reserve(population);
+    if (population > m_steerDy.capacity()) m_steerDy.reserve(population);
+    // the solver's per-fish and per-island scratch, islands never outnumber fish
+    for (auto *rows : {&m_islandParent, &m_bodyIsland, &m_islandBodies, &m_islandBodyStart, &m_islandContactStart}) {
+        if (population + 1 > rows->capacity()) rows->reserve(population + 1);
+    }
+    if (population > m_islandSettled.capacity()) m_islandSettled.reserve(population);
+    if (population > m_islandDepth.capacity()) m_islandDepth.reserve(population);
+    if (population + 1 > m_contactStart.capacity()) m_contactStart.reserve(population + 1);
+    m_grid.reserve(population, m_width, m_height, NPCreature::kBaseRadius);
+    // per contact scratch, each contact is listed once and referenced from both fish
+    size_t contacts = population * kContactsPerFish;
+    size_t bands = (population + kCollisionBand - 1) / kCollisionBand;
+    if (m_bandContacts.size() < bands) m_bandContacts.resize(bands);
+    for (auto &band : m_bandContacts) {
+        if (kCollisionBand * kContactsPerFish > band.capacity()) band.reserve(kCollisionBand * kContactsPerFish);
+    }
+    if (contacts > m_contactList.capacity()) m_contactList.reserve(contacts);
+    if (2 * contacts > m_contactRefs.capacity()) m_contactRefs.reserve(2 * contacts);
+    for (auto *values : {&m_contactIsland, &m_islandContacts}) {
+        if (contacts > values->capacity()) values->reserve(contacts);
+    }
+    for (auto *values : {&m_contactPushX, &m_contactPushY, &m_contactOverlap}) {
+        if (contacts > values->capacity()) values->reserve(contacts);
+    }
+    // a new level can change which one comes next, roll it again
+    if (m_nextLevelReady) {
+        int next = (currentLevel + 1) % static_cast<int>(m_aquariumlevels.size());
+        m_aquariumlevels[next]->populationReset();
+        m_nextLevelReady = false;
+    }
+    m_aquariumlevels.push_back(std::move(level));
 }
 
-void Aquarium::removeCreature(std::shared_ptr<Creature> creature) {
-    auto it = std::find(m_creatures.begin(), m_creatures.end(), creature);
-    if (it != m_creatures.end()) {
-        if (!m_aquariumlevels.empty()) {
-            int idx = currentLevel % static_cast<int>(m_aquariumlevels.size());
-            if (auto npc = std::dynamic_pointer_cast<NPCreature>(*it)) {
-                m_aquariumlevels[idx]->ConsumePopulation(npc->GetType(), npc->getValue());
-            }
-        }
-        m_creatures.erase(it);
+void Aquarium::removeCreature(CreatureHandle creature) {
+    int row = m_creatures.rowOf(creature);
+    if (row < 0) return;
+    if (!m_aquariumlevels.empty()) {
+        int idx = currentLevel % static_cast<int>(m_aquariumlevels.size());
+        m_aquariumlevels[idx]->ConsumePopulation(m_creatures.type[row], m_creatures.value[row]);
     }
+    m_creatures.remove(creature);
+    m_gridDirty = true;
 }
 
 void Aquarium::clearCreatures() {
     m_creatures.clear();
+    m_gridDirty = true;
 }
 
 void Aquarium::update() {
-    // move creatures and powerups
-    for (auto &c : m_creatures) c->move();
+    AQUARIUM_PROFILE("aquarium.update");
+    ++m_tick;
+    updateActivity();
+    if (m_flocking) steerCreatures();
+    moveCreatures();
     for (auto &pu : m_powerUps) pu->move();
 
     // handle repopulation & level progression
+    int level = currentLevel;
     Repopulate();
+    if (m_stepScaleActive) {
+        // fish spawned this tick are awake, after a level change all of them are new
+        if (currentLevel != level) m_stepScale.assign(m_creatures.size(), 1.0f);
+        else m_stepScale.resize(m_creatures.size(), 1.0f);
+        m_awakeCount = static_cast<int>(std::count_if(m_stepScale.begin(), m_stepScale.end(),
+                                                      [](float scale) { return scale != 0.0f; }));
+    }
+
+    resolveCollisions();
+}
+
+// Step scale of every region from its distance to the focus, then of every
+// fish from the region it is in, 0 for fish in a sleeping island
+void Aquarium::updateActivity() {
+    AquariumCreatureStore &s = m_creatures;
+    m_regionsActive = m_nearRadius > 0.0f;
+    m_sleepingCount = 0;
+    if (m_islandSleep) {
+        m_sleepingCount = static_cast<int>(std::count_if(s.rest.begin(), s.rest.end(),
+                                                         [](int ticks) { return ticks >= kSleepTicks; }));
+    }
+    m_stepScaleActive = m_regionsActive || m_sleepingCount > 0;
+    m_awakeCount = static_cast<int>(s.size());
+    if (!m_stepScaleActive) return;
+
+    // without regions the whole tank is one region at full rate
+    int size = std::max({m_width, m_height, 1});
+    int cols = 1, rows = 1;
+    m_regionScale.assign(1, 1.0f);
+    if (m_regionsActive) {
+        size = kActivityRegionSize;
+        cols = std::max(1, (m_width + size - 1) / size);
+        rows = std::max(1, (m_height + size - 1) / size);
+        m_regionScale.resize(cols * rows);
+        float near2 = m_nearRadius * m_nearRadius;
+        float far2 = m_farRadius * m_farRadius;
+        for (int r = 0; r < cols * rows; ++r) {
+            float left = static_cast<float>(r % cols * size), top = static_cast<float>(r / cols * size);
+            float dx = std::max({left - m_focusX, 0.0f, m_focusX - (left + size)});
+            float dy = std::max({top - m_focusY, 0.0f, m_focusY - (top + size)});
+            float d2 = dx * dx + dy * dy;
+            if (d2 <= near2) {
+                m_regionScale[r] = 1.0f;
+            } else if (d2 <= far2 && (m_tick + r) % kDistantInterval == 0) {
+                m_regionScale[r] = static_cast<float>(kDistantInterval);
+            } else {
+                m_regionScale[r] = 0.0f;
+            }
+        }
+    }
+
+    bool sleeping = m_sleepingCount > 0;
+    m_stepScale.resize(s.size());
+    m_workers->parallelFor(s.size(), kMoveGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            int rx = std::min(cols - 1, std::max(0, static_cast<int>(s.x[i]) / size));
+            int ry = std::min(rows - 1, std::max(0, static_cast<int>(s.y[i]) / size));
+            m_stepScale[i] = sleeping && s.rest[i] >= kSleepTicks ? 0.0f : m_regionScale[ry * cols + rx];
+        }
+    });
+}
 
-    // simple collision resolution between NPCs
-    for (size_t i = 0; i < m_creatures.size(); ++i) {
-        for (size_t j = i + 1; j < m_creatures.size(); ++j) {
-            auto a = m_creatures[i];
-            auto b = m_creatures[j];
-            if (checkCollision(a, b)) {
-                a->setDirection(-a->getDx(), -a->getDy());
-                b->setDirection(-b->getDx(), -b->getDy());
-
-                float dx = a->getX() - b->getX();
-                float dy = a->getY() - b->getY();
+// Boids pass. Every fish due to turn sums the neighbours the grid finds within its
+// flocking radius; headings are read from the store and written to scratch,
+// so the result does not depend on the order or the thread fish are steered on.
+void Aquarium::steerCreatures() {
+    AQUARIUM_PROFILE("aquarium.steer");
+    AquariumCreatureStore &s = m_creatures;
+    m_grid.rebuild(s, m_width, m_height);
+    m_steerDx.resize(s.size());
+    m_steerDy.resize(s.size());
+    const float *scale = m_stepScaleActive ? m_stepScale.data() : nullptr;
+    // in grid order, so neighbouring fish share the cells they read
+    const std::vector<int> &order = m_grid.entries();
+    m_workers->parallelFor(order.size(), kSteerGrain, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            int i = order[k];
+            // full rate fish turn on alternate ticks, distant ones whenever they move
+            float step = scale ? scale[i] : 1.0f;
+            if (step == 0.0f || (step == 1.0f && (i + m_tick) % kSteerInterval != 0)) {
+                m_steerDx[i] = s.dx[i];
+                m_steerDy[i] = s.dy[i];
+                continue;
+            }
+            AquariumFlockSteering steer(s, i);
+            float r = steer.radius();
+            m_grid.forEachInBox(s.x[i] - r, s.y[i] - r, s.x[i] + r, s.y[i] + r, [&](int j) { steer.add(j); });
+            steer.result(m_steerDx[i], m_steerDy[i]);
+        }
+    });
+    m_workers->parallelFor(s.size(), kMoveGrain, [&](size_t begin, size_t end) {
+        std::copy(m_steerDx.begin() + begin, m_steerDx.begin() + end, s.dx.begin() + begin);
+        std::copy(m_steerDy.begin() + begin, m_steerDy.begin() + end, s.dy.begin() + begin);
+    });
+}
+
+void Aquarium::moveCreatures() {
+    AQUARIUM_PROFILE("aquarium.move");
+    // move creatures and bounce them off the walls, every fish is independent
+    AquariumCreatureStore &s = m_creatures;
+    const float maxX = static_cast<float>(m_width - 20);
+    const float maxY = static_cast<float>(m_height - 20);
+    const float *scale = m_stepScaleActive ? m_stepScale.data() : nullptr;
+    m_workers->parallelFor(s.size(), kMoveGrain, [&](size_t begin, size_t end) {
+        AquariumMoveCreatures(s, begin, end, maxX, maxY, m_moveKernel, scale);
+    });
+}
+
+// Collision response between NPCs. First every band of the grid finds its
+// contacts against the positions at the start of the pass, reading only. The
+// contacts then join fish into islands that are relaxed together (see
+// relaxIslands); every fish is written by one thread and sums in a fixed
+// order, so the result is the same for any number of threads. Only awake fish look for contacts: two awake fish
+// meet from the lower index, a sleeping one only from the awake side.
+void Aquarium::resolveCollisions() {
+    AQUARIUM_PROFILE("aquarium.collide");
+    AquariumCreatureStore &s = m_creatures;
+    m_grid.rebuild(s, m_width, m_height);
+    const std::vector<int> &entries = m_grid.entries();
+    size_t bands = (entries.size() + kCollisionBand - 1) / kCollisionBand;
+    if (m_bandContacts.size() < bands) m_bandContacts.resize(bands);
+    const float *scale = m_stepScaleActive ? m_stepScale.data() : nullptr;
+    auto asleep = [scale](int i) { return scale && scale[i] == 0.0f; };
+
+    m_workers->parallelFor(entries.size(), kCollisionBand, [&](size_t begin, size_t end) {
+        std::vector<AquariumContact> &contacts = m_bandContacts[begin / kCollisionBand];
+        contacts.clear();
+        for (size_t e = begin; e < end; ++e) {
+            int a = entries[e];
+            if (asleep(a)) continue;
+            m_grid.forEachNeighbor(s.x[a], s.y[a], [&](int b) {
+                if (b == a || (b < a && !asleep(b))) return;
+                if (!checkCollision(s.x[a], s.y[a], s.radius[a], s.x[b], s.y[b], s.radius[b])) return;
+                AquariumContact c{a, b, 1.0f, 0.0f, (s.radius[a] + s.radius[b]) / 2.0f};
+                float dx = s.x[a] - s.x[b];
+                float dy = s.y[a] - s.y[b];
                 float dist = std::sqrt(dx * dx + dy * dy);
                 if (dist > 0.0f) {
-                    float overlap = (a->getCollisionRadius() + b->getCollisionRadius() - dist) / 2.0f;
-                    a->setX(a->getX() + dx / dist * overlap);
-                    a->setY(a->getY() + dy / dist * overlap);
-                    b->setX(b->getX() - dx / dist * overlap);
-                    b->setY(b->getY() - dy / dist * overlap);
+                    c.nx = dx / dist;
+                    c.ny = dy / dist;
+                    c.push = (s.radius[a] + s.radius[b] - dist) / 2.0f;
                 }
+                contacts.push_back(c);
+            });
+        }
+    });
+
+    // index the contacts by creature, counting sort over both ends
+    m_contactList.clear();
+    m_contactStart.assign(s.size() + 1, 0);
+    for (size_t band = 0; band < bands; ++band) {
+        for (const AquariumContact &c : m_bandContacts[band]) {
+            m_contactList.push_back(&c);
+            ++m_contactStart[c.a + 1];
+            ++m_contactStart[c.b + 1];
+        }
+    }
+    for (size_t i = 1; i < m_contactStart.size(); ++i) m_contactStart[i] += m_contactStart[i - 1];
+    m_contactRefs.resize(m_contactStart.back());
+    for (size_t k = 0; k < m_contactList.size(); ++k) {
+        m_contactRefs[m_contactStart[m_contactList[k]->a]++] = static_cast<int>(k);
+        m_contactRefs[m_contactStart[m_contactList[k]->b]++] = static_cast<int>(k);
+    }
+    for (size_t i = m_contactStart.size() - 1; i > 0; --i) m_contactStart[i] = m_contactStart[i - 1];
+    m_contactStart[0] = 0;
+
+    buildIslands();
+    relaxIslands();
+    respondToContacts();
+    // the relaxation moved fish by at most m_gridShift, queryContacts widens
+    // its box by that instead of rebuilding
+    m_gridDirty = false;
+}
+
+// Islands are the connected groups of fish in this tick's contacts. Union-find
+// keeps the lowest row as the root, so the islands and their order only depend
+// on the contacts, not on the order they were joined in.
+void Aquarium::buildIslands() {
+    const size_t n = m_creatures.size();
+    m_islandParent.resize(n);
+    for (size_t i = 0; i < n; ++i) m_islandParent[i] = static_cast<int>(i);
+    auto root = [this](int i) {
+        while (m_islandParent[i] != i) {
+            m_islandParent[i] = m_islandParent[m_islandParent[i]];
+            i = m_islandParent[i];
+        }
+        return i;
+    };
+    for (const AquariumContact *c : m_contactList) {
+        int ra = root(c->a), rb = root(c->b);
+        if (ra != rb) m_islandParent[std::max(ra, rb)] = std::min(ra, rb);
+    }
+
+    // number the islands in root order, roots come first in their island
+    m_islandCount = 0;
+    m_bodyIsland.assign(n, -1);
+    for (size_t i = 0; i < n; ++i) {
+        if (m_contactStart[i] == m_contactStart[i + 1]) continue;
+        int r = root(static_cast<int>(i));
+        if (r == static_cast<int>(i)) m_bodyIsland[i] = m_islandCount++;
+        else m_bodyIsland[i] = m_bodyIsland[r];
+    }
+    m_contactIsland.resize(m_contactList.size());
+    for (size_t k = 0; k < m_contactList.size(); ++k) m_contactIsland[k] = m_bodyIsland[m_contactList[k]->a];
+
+    // group bodies and contacts by island with the same counting sort as the grid
+    m_islandBodyStart.assign(m_islandCount + 1, 0);
+    m_islandContactStart.assign(m_islandCount + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        if (m_bodyIsland[i] >= 0) ++m_islandBodyStart[m_bodyIsland[i] + 1];
+    }
+    for (int island : m_contactIsland) ++m_islandContactStart[island + 1];
+    for (int k = 0; k < m_islandCount; ++k) {
+        m_islandBodyStart[k + 1] += m_islandBodyStart[k];
+        m_islandContactStart[k + 1] += m_islandContactStart[k];
+    }
+    m_islandBodies.resize(m_islandBodyStart.back());
+    m_islandContacts.resize(m_islandContactStart.back());
+    for (size_t i = 0; i < n; ++i) {
+        if (m_bodyIsland[i] >= 0) m_islandBodies[m_islandBodyStart[m_bodyIsland[i]]++] = static_cast<int>(i);
+    }
+    for (size_t k = 0; k < m_contactIsland.size(); ++k) {
+        m_islandContacts[m_islandContactStart[m_contactIsland[k]]++] = static_cast<int>(k);
+    }
+    // the scatters advanced every start to the end of its island, shift them back
+    for (int k = m_islandCount; k > 0; --k) {
+        m_islandBodyStart[k] = m_islandBodyStart[k - 1];
+        m_islandContactStart[k] = m_islandContactStart[k - 1];
+    }
+    m_islandBodyStart[0] = 0;
+    m_islandContactStart[0] = 0;
+}
+
+// Jacobi relaxation in up to m_solverIterations rounds. Each round measures
+// every contact against the current positions, then moves every fish by the
+// average of its contacts' pushes, summed in band order. So the order contacts
+// are listed in does not matter, crowded fish don't overshoot, and one big
+// island is spread over the workers like many small ones. An island drops out
+// once none of its overlaps exceeds kContactSlop.
+void Aquarium::relaxIslands() {
+    AquariumCreatureStore &s = m_creatures;
+    const size_t contactCount = m_contactList.size();
+    m_contactPushX.resize(contactCount);
+    m_contactPushY.resize(contactCount);
+    m_contactOverlap.resize(contactCount);
+    m_islandSettled.assign(m_islandCount, 0);
+    m_islandDepth.resize(m_islandCount);
+    m_gridShift = 0.0f;
+
+    for (int round = 0; round < m_solverIterations; ++round) {
+        m_workers->parallelFor(contactCount, kContactGrain, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                m_contactOverlap[k] = 0.0f;
+                if (m_islandSettled[m_contactIsland[k]]) continue;
+                const AquariumContact &c = *m_contactList[k];
+                if (round == 0) {
+                    // nothing moved since the contacts were found
+                    m_contactOverlap[k] = 2.0f * c.push;
+                    m_contactPushX[k] = c.nx * c.push;
+                    m_contactPushY[k] = c.ny * c.push;
+                    continue;
+                }
+                float dx = s.x[c.a] - s.x[c.b];
+                float dy = s.y[c.a] - s.y[c.b];
+                float reach = s.radius[c.a] + s.radius[c.b];
+                float dist2 = dx * dx + dy * dy;
+                if (dist2 >= reach * reach) continue;
+                float dist = std::sqrt(dist2);
+                float nx = c.nx, ny = c.ny;
+                if (dist > 0.0f) {
+                    nx = dx / dist;
+                    ny = dy / dist;
+                }
+                float push = (reach - dist) / 2.0f;
+                m_contactOverlap[k] = reach - dist;
+                m_contactPushX[k] = nx * push;
+                m_contactPushY[k] = ny * push;
+            }
+        });
+        m_workers->parallelFor(m_islandCount, kIslandGrain, [&](size_t begin, size_t end) {
+            for (size_t island = begin; island < end; ++island) {
+                if (m_islandSettled[island]) continue;
+                float deepest = 0.0f;
+                for (int r = m_islandContactStart[island]; r < m_islandContactStart[island + 1]; ++r) {
+                    deepest = std::max(deepest, m_contactOverlap[m_islandContacts[r]]);
+                }
+                m_islandDepth[island] = deepest;
+                m_islandSettled[island] = deepest <= kContactSlop;
             }
+        });
+        // no fish moves further this round than half the deepest overlap left
+        bool settled = true;
+        float deepest = 0.0f;
+        for (int island = 0; island < m_islandCount; ++island) {
+            if (m_islandSettled[island]) continue;
+            settled = false;
+            deepest = std::max(deepest, m_islandDepth[island]);
         }
+        if (settled) break;
+        m_gridShift += deepest / 2.0f;
+
+        m_workers->parallelFor(m_islandBodies.size(), kMoveGrain, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                int i = m_islandBodies[b];
+                if (m_islandSettled[m_bodyIsland[i]]) continue;
+                float px = 0.0f, py = 0.0f;
+                int pushes = 0;
+                for (int r = m_contactStart[i]; r < m_contactStart[i + 1]; ++r) {
+                    int k = m_contactRefs[r];
+                    if (m_contactOverlap[k] <= 0.0f) continue;
+                    float side = (m_contactList[k]->a == i) ? 1.0f : -1.0f;
+                    px += side * m_contactPushX[k];
+                    py += side * m_contactPushY[k];
+                    ++pushes;
+                }
+                if (pushes == 0) continue;
+                s.x[i] += px / pushes;
+                s.y[i] += py / pushes;
+            }
+        });
     }
 }
 
-void Aquarium::draw() const {
-    for (const auto &c : m_creatures) c->draw();
-    for (const auto &pu : m_powerUps) pu->draw();
+// Fish swimming into their contacts turn away along the summed normal instead
+// of reversing, so they don't meet again on the next tick. With island sleep,
+// an island rests when all its fish run at full rate and barely moved this
+// tick; a fish touching nothing is an island of its own.
+void Aquarium::respondToContacts() {
+    AquariumCreatureStore &s = m_creatures;
+    const float *scale = m_stepScaleActive ? m_stepScale.data() : nullptr;
+    auto still = [&](int i) {
+        float movedX = s.x[i] - s.prevX[i], movedY = s.y[i] - s.prevY[i];
+        return (!scale || scale[i] == 1.0f) && movedX * movedX + movedY * movedY < kRestDistance * kRestDistance;
+    };
+    m_workers->parallelFor(m_islandBodies.size(), kMoveGrain, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            int i = m_islandBodies[b];
+            float nx = 0.0f, ny = 0.0f;
+            for (int r = m_contactStart[i]; r < m_contactStart[i + 1]; ++r) {
+                const AquariumContact &c = *m_contactList[m_contactRefs[r]];
+                float side = (c.a == i) ? 1.0f : -1.0f;
+                nx += side * c.nx;
+                ny += side * c.ny;
+            }
+            float length2 = nx * nx + ny * ny;
+            float into = s.dx[i] * nx + s.dy[i] * ny;
+            if (length2 > 1e-12f && into < 0.0f) {
+                float turn = 2.0f * into / length2;
+                s.dx[i] -= turn * nx;
+                s.dy[i] -= turn * ny;
+            }
+        }
+    });
+    if (!m_islandSleep) return;
+
+    m_workers->parallelFor(s.size(), kMoveGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            // sleeping fish nobody touched keep their count
+            if (m_bodyIsland[i] >= 0 || (scale && scale[i] == 0.0f)) continue;
+            s.rest[i] = still(static_cast<int>(i)) ? std::min(s.rest[i] + 1, kSleepTicks) : 0;
+        }
+    });
+    m_workers->parallelFor(m_islandCount, kIslandGrain, [&](size_t begin, size_t end) {
+        for (size_t island = begin; island < end; ++island) {
+            bool resting = true;
+            for (int r = m_islandBodyStart[island]; resting && r < m_islandBodyStart[island + 1]; ++r) {
+                resting = still(m_islandBodies[r]);
+            }
+            for (int r = m_islandBodyStart[island]; r < m_islandBodyStart[island + 1]; ++r) {
+                int i = m_islandBodies[r];
+                s.rest[i] = resting ? std::min(s.rest[i] + 1, kSleepTicks) : 0;
+            }
+        }
+    });
+}
+
+
+// ---- Camera
+// Keeps the view inside the world along one axis
+static float FollowAxis(float target, float view, float world) {
+    if (world <= view) return (world - view) / 2.0f;
+    return std::min(std::max(target - view / 2.0f, 0.0f), world - view);
+}
+
+void AquariumCamera::follow(float x, float y) {
+    m_view.x = FollowAxis(x, m_view.width, m_worldWidth);
+    m_view.y = FollowAxis(y, m_view.height, m_worldHeight);
+}
+
+void AquariumCamera::begin() const {
+    ofPushMatrix();
+    ofTranslate(-m_view.x, -m_view.y);
+}
+
+void AquariumCamera::end() const {
+    ofPopMatrix();
+}
+
+// Non-short-circuit on purpose: which side a fish is off the view is random,
+// one combined branch predicts far better than four
+static bool InView(const ofRectangle& view, float x0, float y0, float x1, float y1) {
+    return (x1 >= view.x) & (x0 <= view.x + view.width) & (y1 >= view.y) & (y0 <= view.y + view.height);
 }
 
 
+void Aquarium::draw(float alpha) const {
+    draw(alpha, ofRectangle(0, 0, m_width, m_height));
+}
+
+void Aquarium::draw(float alpha, const ofRectangle& view) const {
+    AQUARIUM_PROFILE("aquarium.draw");
+    if (m_batchedDraw) {
+        drawBatched(alpha, view);
+    } else {
+        drawUnbatched(alpha, view);
+    }
+    for (const auto &pu : m_powerUps) {
+        const auto &sprite = pu->getSprite();
+        if (!sprite) continue;
+        float x = pu->getX();
+        float y = pu->getY();
+        if (InView(view, x, y, x + sprite->getWidth(), y + sprite->getHeight())) pu->draw();
+    }
+}
+
+// Both draws test each fish's sprite rectangle against the view first, so
+// what reaches the GPU scales with the fish on screen, not the whole tank
+void Aquarium::drawUnbatched(float alpha, const ofRectangle& view) const {
+    const AquariumCreatureStore &s = m_creatures;
+    m_drawnCount = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        const auto &sprite = m_sprites[s.spriteId[i]];
+        if (!sprite) continue;
+        float x = s.prevX[i] + (s.x[i] - s.prevX[i]) * alpha;
+        float y = s.prevY[i] + (s.y[i] - s.prevY[i]) * alpha;
+        if (!InView(view, x, y, x + sprite->getWidth(), y + sprite->getHeight())) continue;
+        ++m_drawnCount;
+        ofSetColor(255, 255, 255, static_cast<int>(255 * spawnFade(i, alpha)));
+        sprite->draw(x, y, s.dx[i] < 0);
+    }
+    ofSetColor(ofColor::white);
+}
 
-std::shared_ptr<Creature> Aquarium::getCreatureAt(int i) {
-    if (i < 0 || static_cast<size_t>(i) >= m_creatures.size()) return nullptr;
-    return m_creatures[i];
+// 0 on the tick a fish spawns, 1 once it has faded in
+float Aquarium::spawnFade(size_t row, float alpha) const {
+    float age = static_cast<float>(m_tick - m_creatures.born[row]) + alpha;
+    return std::min(1.0f, age / kSpawnFadeTicks);
+}
+
+void Aquarium::drawBatched(float alpha, const ofRectangle& view) const {
+    const AquariumCreatureStore &s = m_creatures;
+    m_drawnCount = 0;
+    if (m_spriteBatches.size() < m_sprites.size()) m_spriteBatches.resize(m_sprites.size());
+    for (auto &batch : m_spriteBatches) {
+        batch.clear();
+        batch.setMode(OF_PRIMITIVE_TRIANGLES);
+        batch.setUsage(GL_STREAM_DRAW);
+    }
+
+    // one textured quad per fish, mirrored fish swap their u coordinates and
+    // new fish fade in through the vertex alpha
+    for (size_t i = 0; i < s.size(); ++i) {
+        const auto &sprite = m_sprites[s.spriteId[i]];
+        if (!sprite) continue;
+        float x0 = s.prevX[i] + (s.x[i] - s.prevX[i]) * alpha;
+        float y0 = s.prevY[i] + (s.y[i] - s.prevY[i]) * alpha;
+        float x1 = x0 + sprite->getWidth(), y1 = y0 + sprite->getHeight();
+        if (!InView(view, x0, y0, x1, y1)) continue;
+        ++m_drawnCount;
+
+        ofVboMesh &batch = m_spriteBatches[s.spriteId[i]];
+        const ofTexture &tex = sprite->getTexture();
+        glm::vec2 uv0 = tex.getCoordFromPercent(0, 0);
+        glm::vec2 uv1 = tex.getCoordFromPercent(1, 1);
+        if (s.dx[i] < 0) std::swap(uv0.x, uv1.x);
+        ofFloatColor tint(1.0f, 1.0f, 1.0f, spawnFade(i, alpha));
+        ofIndexType base = static_cast<ofIndexType>(batch.getNumVertices());
+        batch.addVertex(glm::vec3(x0, y0, 0)); batch.addTexCoord(glm::vec2(uv0.x, uv0.y)); batch.addColor(tint);
+        batch.addVertex(glm::vec3(x1, y0, 0)); batch.addTexCoord(glm::vec2(uv1.x, uv0.y)); batch.addColor(tint);
+        batch.addVertex(glm::vec3(x1, y1, 0)); batch.addTexCoord(glm::vec2(uv1.x, uv1.y)); batch.addColor(tint);
+        batch.addVertex(glm::vec3(x0, y1, 0)); batch.addTexCoord(glm::vec2(uv0.x, uv1.y)); batch.addColor(tint);
+        batch.addIndex(base);     batch.addIndex(base + 1); batch.addIndex(base + 2);
+        batch.addIndex(base);     batch.addIndex(base + 2); batch.addIndex(base + 3);
+    }
+
+    for (size_t id = 0; id < m_spriteBatches.size(); ++id) {
+        if (m_spriteBatches[id].getNumVertices() == 0) continue;
+        const ofTexture &tex = m_sprites[id]->getTexture();
+        tex.bind();
+        m_spriteBatches[id].draw();
+        tex.unbind();
+    }
 }
 
 void Aquarium::Repopulate() {
+    AQUARIUM_PROFILE("aquarium.spawn");
     if (m_aquariumlevels.empty()) return;
 
     int idx = currentLevel % static_cast<int>(m_aquariumlevels.size());
     auto level = m_aquariumlevels[idx];
 
+    // drop the spawned front of the queue, the rest moves down without allocating
+    m_spawnQueue.erase(m_spawnQueue.begin(), m_spawnQueue.begin() + m_spawnHead);
+    m_spawnHead = 0;
+
+    bool levelChanged = false;
     if (level->isCompleted()) {
         level->levelReset();
         ++currentLevel;
         idx = currentLevel % static_cast<int>(m_aquariumlevels.size());
         level = m_aquariumlevels[idx];
         clearCreatures();
+        m_spawnQueue.clear();
+        if (m_nextLevelReady) {
+            m_spawnQueue.swap(m_nextLevelSpawns);
+            m_nextLevelReady = false;
+        }
+        levelChanged = true;
     }
 
-    auto toSpawn = level->Repopulate();
-    for (auto t : toSpawn) {
-        SpawnCreature(t);
-    }
+    // fish eaten since the last tick, or the whole level if it wasn't rolled ahead
+    m_spawnTypes.clear();
+    level->Repopulate(m_spawnTypes);
+    for (auto t : m_spawnTypes) m_spawnQueue.push_back(rollSpawn(t));
+    spawnQueued(m_spawnBudget);
+
+    // keep the transition tick light, roll the next level on the one after
+    if (!levelChanged && !m_nextLevelReady) prepareNextLevel();
+}
+
+void Aquarium::prepareNextLevel() {
+    // with a single level the next one is the current one, which is still in play
+    if (m_aquariumlevels.size() < 2) return;
+    int next = (currentLevel + 1) % static_cast<int>(m_aquariumlevels.size());
+    m_spawnTypes.clear();
+    m_aquariumlevels[next]->populationReset();
+    m_aquariumlevels[next]->Repopulate(m_spawnTypes);
+    m_nextLevelSpawns.clear();
+    for (auto t : m_spawnTypes) m_nextLevelSpawns.push_back(rollSpawn(t));
+    m_nextLevelReady = true;
+}
+
+void Aquarium::spawnQueued(int budget) {
+    size_t end = m_spawnQueue.size();
+    if (budget > 0) end = std::min(end, m_spawnHead + static_cast<size_t>(budget));
+    for (; m_spawnHead < end; ++m_spawnHead) spawn(m_spawnQueue[m_spawnHead]);
+}
+
+void Aquarium::flushSpawns() {
+    spawnQueued(0);
 }
 
 void Aquarium::SpawnCreature(AquariumCreatureType type) {
-    int x = rand() % std::max(1, getWidth());
-    int y = rand() % std::max(1, getHeight());
-    int speed = 1 + rand() % 25;
+    spawn(rollSpawn(type));
+}
 
-    switch (type) {
+AquariumSpawn Aquarium::rollSpawn(AquariumCreatureType type) {
+    AquariumSpawn sp;
+    sp.type = type;
+    sp.x = m_random.nextInt(std::max(1, getWidth()));
+    sp.y = m_random.nextInt(std::max(1, getHeight()));
+    sp.speed = 1 + m_random.nextInt(25);
+    sp.dx = static_cast<float>(m_random.nextInt(3) - 1);
+    sp.dy = static_cast<float>(m_random.nextInt(3) - 1);
+    return sp;
+}
+
+void Aquarium::spawn(const AquariumSpawn& sp) {
+    // the fish classes only set up the initial state, the store owns it
+    // afterwards; the direction comes from the aquarium's generator
+    switch (sp.type) {
         case AquariumCreatureType::NPCreature:
-            addCreature(std::make_shared<NPCreature>(x, y, speed, m_sprite_manager->GetSprite(AquariumCreatureType::NPCreature)));
+            addCreature(NPCreature(sp.x, sp.y, sp.speed, sp.dx, sp.dy, nullptr));
             break;
         case AquariumCreatureType::BiggerFish:
-            addCreature(std::make_shared<BiggerFish>(x, y, speed, m_sprite_manager->GetSprite(AquariumCreatureType::BiggerFish)));
+            addCreature(BiggerFish(sp.x, sp.y, sp.speed, sp.dx, sp.dy, nullptr));
             break;
         case AquariumCreatureType::FastFish:
-            addCreature(std::make_shared<FastFish>(x, y, speed, m_sprite_manager->GetSprite(AquariumCreatureType::FastFish)));
+            addCreature(FastFish(sp.x, sp.y, sp.speed, sp.dx, sp.dy, nullptr));
             break;
         case AquariumCreatureType::ArmoredFish:
-            addCreature(std::make_shared<ArmoredFish>(x, y, speed, m_sprite_manager->GetSprite(AquariumCreatureType::ArmoredFish)));
+            addCreature(ArmoredFish(sp.x, sp.y, sp.speed, sp.dx, sp.dy, nullptr));
             break;
         default:
             ofLogError() << "Unknown creature type to spawn!";
@@ -363,16 +1107,14 @@ void Aquarium::SpawnCreature(AquariumCreatureType type) {
 }
 
 void Aquarium::SpawnPowerUp(PowerUp::Type type) {
-    int x = rand() % std::max(1, getWidth());
-    int y = rand() % std::max(1, getHeight() / 2);
-
-    std::shared_ptr<GameSprite> sprite;
-    switch (type) {
-        case PowerUp::Type::SPEED: sprite = std::make_shared<GameSprite>("speed_powerup.png", 40, 40); break;
-        case PowerUp::Type::POWER: sprite = std::make_shared<GameSprite>("power_powerup.png", 40, 40); break;
-        case PowerUp::Type::SIZE:  sprite = std::make_shared<GameSprite>("size_powerup.png",  40, 40); break;
-    }
-    m_powerUps.push_back(std::make_shared<PowerUp>(x, y, type, sprite));
+    int x = m_random.nextInt(std::max(1, getWidth()));
+    int y = m_random.nextInt(std::max(1, getHeight() / 2));
+
+    // sprites come from the manager's cache, spawning never touches the disk
+    std::shared_ptr<GameSprite> sprite = m_sprite_manager ? m_sprite_manager->GetPowerUpSprite(type) : nullptr;
+    auto powerUp = std::make_shared<PowerUp>(x, y, type, sprite);
+    powerUp->setBounds(m_width, m_height);
+    m_powerUps.push_back(std::move(powerUp));
 }
 
 void Aquarium::removePowerUp(std::shared_ptr<PowerUp> powerUp) {
@@ -380,31 +1122,260 @@ void Aquarium::removePowerUp(std::shared_ptr<PowerUp> powerUp) {
     if (it != m_powerUps.end()) m_powerUps.erase(it);
 }
 
+void Aquarium::queryContacts(float x, float y, float radius, AquariumPlayerContacts& out) {
+    const AquariumCreatureStore &s = m_creatures;
+    if (m_gridDirty) {
+        m_grid.rebuild(s, m_width, m_height);
+        m_gridDirty = false;
+        m_gridShift = 0.0f;
+    }
+    // sized once for the whole store, the caller reuses `out` every tick
+    if (out.creatures.capacity() < m_creatures.capacity()) out.creatures.reserve(m_creatures.capacity());
+    if (out.powerUps.capacity() < m_powerUps.capacity()) out.powerUps.reserve(m_powerUps.capacity());
+    // any creature that can reach the circle sat in a cell touching this box
+    // at the last rebuild; it moved at most m_gridShift since
+    float reach = radius + m_grid.cellSize() / 2.0f + m_gridShift;
+    m_grid.forEachInBox(x - reach, y - reach, x + reach, y + reach, [&](int i) {
+        if (checkCollision(x, y, radius, s.x[i], s.y[i], s.radius[i])) out.creatures.push_back(s.handleAt(i));
+    });
+    for (const auto &pu : m_powerUps) {
+        if (checkCollision(x, y, radius, pu->getX(), pu->getY(), pu->getCollisionRadius())) out.powerUps.push_back(pu);
+    }
+}
 
-std::shared_ptr<GameEvent> DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium,
-                                                    std::shared_ptr<PlayerCreature> player) {
-    if (!aquarium || !player) return nullptr;
 
-    for (int i = 0; i < aquarium->getCreatureCount(); ++i) {
-        auto npc = aquarium->getCreatureAt(i);
-        if (npc && checkCollision(player, npc)) {
-            return std::make_shared<GameEvent>(GameEventType::COLLISION, player, npc);
+// ---- Snapshots
+// Fixed-size records, one section each (see AquariumSnapshotSection)
+namespace {
+
+struct WorldRecord {
+    uint64_t seed;
+    uint64_t randomState;
+    int32_t width;
+    int32_t height;
+    int32_t level;
+    int32_t tick;
+    int32_t spawnBudget;
+    int32_t nextLevelReady;
+    int32_t levelCount;
+    int32_t reserved;
+};
+
+struct LevelRecord {
+    int32_t score;
+    int32_t nodeCount;
+};
+
+struct LevelNodeRecord {
+    int32_t type;
+    int32_t population;
+    int32_t currentPopulation;
+};
+
+struct PowerUpRecord {
+    float x;
+    float y;
+    int32_t type;
+};
+
+struct PlayerRecord {
+    float x;
+    float y;
+    float dx;
+    float dy;
+    float collisionRadius;
+    int32_t speed;
+    int32_t score;
+    int32_t lives;
+    int32_t power;
+    int32_t damageDebounce;
+    int32_t flashFrames;
+    int32_t flipped;
+};
+
+uint32_t SectionId(AquariumSnapshotSection section, int offset = 0) {
+    return static_cast<uint32_t>(section) + static_cast<uint32_t>(offset);
+}
+
+} // namespace
+
+void PlayerCreature::saveSnapshot(SnapshotWriter& out) const {
+    PlayerRecord r{m_x, m_y, m_dx, m_dy, m_collisionRadius, m_speed, m_score, m_lives, m_power,
+                   m_damage_debounce, m_flashFrames, m_flipped ? 1 : 0};
+    out.add(SectionId(AquariumSnapshotSection::PLAYER), &r, 1);
+}
+
+bool PlayerCreature::loadSnapshot(const SnapshotReader& in) {
+    PlayerRecord r;
+    if (!in.readOne(SectionId(AquariumSnapshotSection::PLAYER), r)) return false;
+    m_x = m_prevX = r.x;
+    m_y = m_prevY = r.y;
+    m_dx = r.dx;
+    m_dy = r.dy;
+    m_collisionRadius = r.collisionRadius;
+    m_speed = r.speed;
+    m_score = r.score;
+    m_lives = r.lives;
+    m_power = r.power;
+    m_damage_debounce = r.damageDebounce;
+    m_flashFrames = r.flashFrames;
+    m_flipped = r.flipped != 0;
+    ++m_statsRevision;
+    return true;
+}
+
+void Aquarium::saveSnapshot(SnapshotWriter& out) const {
+    WorldRecord world{m_random.getSeed(), m_random.getState(), m_width, m_height, currentLevel, m_tick,
+                      m_spawnBudget, m_nextLevelReady ? 1 : 0, static_cast<int32_t>(m_aquariumlevels.size()), 0};
+    out.add(SectionId(AquariumSnapshotSection::WORLD), &world, 1);
+
+    std::vector<LevelRecord> levels;
+    std::vector<LevelNodeRecord> nodes;
+    for (const auto &level : m_aquariumlevels) {
+        levels.push_back(LevelRecord{level->getLevelScore(), static_cast<int32_t>(level->getPopulation().size())});
+        for (const auto &node : level->getPopulation()) {
+            nodes.push_back(LevelNodeRecord{static_cast<int32_t>(node->creatureType), node->population, node->currentPopulation});
         }
     }
-    return nullptr;
+    out.add(SectionId(AquariumSnapshotSection::LEVELS), levels);
+    out.add(SectionId(AquariumSnapshotSection::LEVEL_NODES), nodes);
+
+    std::vector<PowerUpRecord> powerUps;
+    for (const auto &pu : m_powerUps) {
+        powerUps.push_back(PowerUpRecord{pu->getX(), pu->getY(), static_cast<int32_t>(pu->getType())});
+    }
+    out.add(SectionId(AquariumSnapshotSection::POWER_UPS), powerUps);
+    out.add(SectionId(AquariumSnapshotSection::SPAWN_QUEUE), m_spawnQueue.data() + m_spawnHead,
+            m_spawnQueue.size() - m_spawnHead);
+    out.add(SectionId(AquariumSnapshotSection::NEXT_LEVEL_SPAWNS), m_nextLevelSpawns);
+
+    // columns go out as they are, a load is one copy per column
+    int column = 0;
+    m_creatures.forEachDataColumn([&](const auto &values) {
+        out.add(SectionId(AquariumSnapshotSection::CREATURES, column++), values);
+    });
 }
 
-std::shared_ptr<PowerUp> DetectPowerUpCollision(std::shared_ptr<Aquarium> aquarium,
-                                                std::shared_ptr<PlayerCreature> player) {
-    if (!aquarium || !player) return nullptr;
+bool Aquarium::loadSnapshot(const SnapshotReader& in) {
+    // check everything before touching the tank, a bad file leaves it as it was
+    WorldRecord world;
+    std::vector<LevelRecord> levels;
+    std::vector<LevelNodeRecord> nodes;
+    if (in.getVersion() != kAquariumSnapshotVersion ||
+        !in.readOne(SectionId(AquariumSnapshotSection::WORLD), world) ||
+        !in.read(SectionId(AquariumSnapshotSection::LEVELS), levels) ||
+        !in.read(SectionId(AquariumSnapshotSection::LEVEL_NODES), nodes)) {
+        ofLogError() << "Snapshot is incomplete or from another version";
+        return false;
+    }
+    bool sameLevels = world.levelCount == static_cast<int32_t>(m_aquariumlevels.size()) &&
+                      levels.size() == m_aquariumlevels.size();
+    size_t node = 0;
+    for (size_t l = 0; sameLevels && l < levels.size(); ++l) {
+        const auto &population = m_aquariumlevels[l]->getPopulation();
+        sameLevels = levels[l].nodeCount == static_cast<int32_t>(population.size());
+        for (size_t k = 0; sameLevels && k < population.size(); ++k, ++node) {
+            sameLevels = node < nodes.size() &&
+                         nodes[node].type == static_cast<int32_t>(population[k]->creatureType) &&
+                         nodes[node].population == population[k]->population;
+        }
+    }
+    if (!sameLevels) {
+        ofLogError() << "Snapshot was saved with different levels";
+        return false;
+    }
+    // spawnBudget 0 spawns a whole level at once, the level index only grows
+    if (world.width <= 0 || world.height <= 0 || world.level < 0 || world.spawnBudget < 0 ||
+        m_aquariumlevels.empty()) {
+        ofLogError() << "Snapshot has an invalid world record";
+        return false;
+    }
 
-    const auto &pus = aquarium->GetPowerUps();
-    for (const auto &pu : pus) {
-        if (checkCollision(std::static_pointer_cast<Creature>(player), pu)) {
-            return pu;
+    // types and sprite ids index tables, so every row is checked in place;
+    // sprite ids are the type, every one of them is loaded below
+    size_t sprites = std::max(m_sprites.size(), static_cast<size_t>(kAquariumCreatureTypeCount));
+    auto validType = [](int type) { return type >= 0 && type < kAquariumCreatureTypeCount; };
+    size_t rows = 0;
+    int column = 0;
+    bool columnsValid = true;
+    m_creatures.forEachDataColumn([&](auto &values) {
+        size_t count = 0;
+        using Value = typename std::decay_t<decltype(values)>::value_type;
+        const unsigned char *bytes = in.find<Value>(SectionId(AquariumSnapshotSection::CREATURES, column++), count);
+        if (column == 1) rows = count;
+        columnsValid = columnsValid && bytes && count == rows;
+        if (!columnsValid) return;
+        bool isType = static_cast<const void*>(&values) == &m_creatures.type;
+        bool isSprite = static_cast<const void*>(&values) == &m_creatures.spriteId;
+        for (size_t i = 0; (isType || isSprite) && columnsValid && i < count; ++i) {
+            Value value;
+            std::memcpy(&value, bytes + i * sizeof(Value), sizeof(Value));
+            int index = static_cast<int>(value);
+            columnsValid = isType ? validType(index) : index >= 0 && static_cast<size_t>(index) < sprites;
         }
+    });
+    std::vector<PowerUpRecord> powerUps;
+    std::vector<AquariumSpawn> spawnQueue, nextLevelSpawns;
+    if (!columnsValid ||
+        !in.read(SectionId(AquariumSnapshotSection::POWER_UPS), powerUps) ||
+        !in.read(SectionId(AquariumSnapshotSection::SPAWN_QUEUE), spawnQueue) ||
+        !in.read(SectionId(AquariumSnapshotSection::NEXT_LEVEL_SPAWNS), nextLevelSpawns)) {
+        ofLogError() << "Snapshot is missing creature data or has invalid creatures";
+        return false;
+    }
+    bool recordsValid = true;
+    for (const auto &r : powerUps) {
+        recordsValid = recordsValid && r.type >= 0 && r.type <= static_cast<int32_t>(PowerUp::Type::SIZE);
     }
-    return nullptr;
+    for (const auto &spawn : spawnQueue) recordsValid = recordsValid && validType(static_cast<int>(spawn.type));
+    for (const auto &spawn : nextLevelSpawns) recordsValid = recordsValid && validType(static_cast<int>(spawn.type));
+    if (!recordsValid) {
+        ofLogError() << "Snapshot has invalid power-ups or spawns";
+        return false;
+    }
+
+    // world, levels and the generator
+    m_random.restore(world.seed, world.randomState);
+    m_width = world.width;
+    m_height = world.height;
+    currentLevel = world.level;
+    m_tick = world.tick;
+    m_spawnBudget = world.spawnBudget;
+    m_nextLevelReady = world.nextLevelReady != 0;
+    m_spawnQueue.assign(spawnQueue.begin(), spawnQueue.end());
+    m_nextLevelSpawns.assign(nextLevelSpawns.begin(), nextLevelSpawns.end());
+    m_spawnHead = 0;
+    node = 0;
+    for (size_t l = 0; l < levels.size(); ++l) {
+        m_aquariumlevels[l]->setLevelScore(levels[l].score);
+        for (const auto &n : m_aquariumlevels[l]->getPopulation()) n->currentPopulation = nodes[node++].currentPopulation;
+    }
+
+    m_creatures.clear();
+    column = 0;
+    m_creatures.forEachDataColumn([&](auto &values) { in.read(SectionId(AquariumSnapshotSection::CREATURES, column++), values); });
+    m_creatures.rebuildSlots();
+    for (int t = 0; t < kAquariumCreatureTypeCount; ++t) spriteIdFor(static_cast<AquariumCreatureType>(t));
+    m_gridDirty = true;
+
+    m_powerUps.clear();
+    for (const auto &r : powerUps) {
+        auto type = static_cast<PowerUp::Type>(r.type);
+        std::shared_ptr<GameSprite> sprite = m_sprite_manager ? m_sprite_manager->GetPowerUpSprite(type) : nullptr;
+        auto powerUp = std::make_shared<PowerUp>(r.x, r.y, type, sprite);
+        powerUp->setBounds(m_width, m_height);
+        m_powerUps.push_back(std::move(powerUp));
+    }
+    return true;
+}
+
+
+void DetectPlayerContacts(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player,
+                          AquariumPlayerContacts& out) {
+    AQUARIUM_PROFILE("player.contacts");
+    out.clear();
+    if (!aquarium || !player) return;
+    aquarium->queryContacts(player->getX(), player->getY(), player->getCollisionRadius(), out);
 }
 
 
@@ -413,54 +1384,166 @@ AquariumGameScene::AquariumGameScene(std::shared_ptr<PlayerCreature> player,
                                      std::string name)
     : m_player(std::move(player)), m_aquarium(std::move(aquarium)), m_name(std::move(name))
 {
-    if (!m_ambientSound.load("sounds/underwater_loop.mp3")) {
+    // streamed, so the loop is decoded while it plays instead of up front
+    if (!m_ambientSound.load("sounds/underwater_loop.mp3", true)) {
         ofLogError() << "Failed to load ambient sound: sounds/underwater_loop.mp3";
     } else {
         m_ambientSound.setLoop(true);
         m_ambientSound.setVolume(0.5f);
-        m_ambientSound.play();
     }
 }
 
+void AquariumGameScene::OnEnter() {
+    m_ambientSound.play();
+}
+
+void AquariumGameScene::OnExit() {
+    m_ambientSound.stop();
+}
+
 void AquariumGameScene::Update() {
-    m_player->update();
-
-    if (updateControl.tick()) {
-        // Player vs NPC collision
-        auto event = DetectAquariumCollisions(m_aquarium, m_player);
-        if (event && event->isCollisionEvent()) {
-            if (event->creatureB) {
-                if (m_player->getPower() < event->creatureB->getValue()) {
-                    m_player->loseLife(3 * 60);
-                    if (m_player->getLives() <= 0) {
-                        m_lastEvent = std::make_shared<GameEvent>(GameEventType::GAME_OVER, m_player, nullptr);
-                        return;
-                    }
-                } else {
-                    m_aquarium->removeCreature(event->creatureB);
-                    m_player->addToScore(1, event->creatureB->getValue());
-                    if (m_player->getScore() % 25 == 0) m_player->increasePower(1);
-                }
+    double frameTime = m_frameTime >= 0.0 ? m_frameTime : ofGetLastFrameTime();
+    m_frameTime = -1.0;
+    Advance(frameTime);
+}
+
+void AquariumGameScene::Advance(double frameTime) {
+    int playerSteps = m_playerClock.advance(frameTime);
+    for (int i = 0; i < playerSteps; ++i) m_player->update();
+
+    int worldTicks = m_worldClock.advance(frameTime);
+    for (int i = 0; i < worldTicks; ++i) {
+        Tick();
+        if (m_gameOver) return;
+    }
+}
+
+void AquariumGameScene::HandleInput(const InputCommand& command) {
+    PlayerCreature &p = *m_player;
+    float keepDx = p.isXDirectionActive() ? p.getDx() : 0;
+    float keepDy = p.isYDirectionActive() ? p.getDy() : 0;
+    switch (command.key) {
+        case InputKey::UP:
+            p.setDirection(keepDx, command.pressed ? -1 : 0);
+            break;
+        case InputKey::DOWN:
+            p.setDirection(keepDx, command.pressed ? 1 : 0);
+            break;
+        case InputKey::LEFT:
+            p.setDirection(command.pressed ? -1 : 0, keepDy);
+            if (command.pressed) p.setFlipped(true);
+            break;
+        case InputKey::RIGHT:
+            p.setDirection(command.pressed ? 1 : 0, keepDy);
+            if (command.pressed) p.setFlipped(false);
+            break;
+    }
+    p.move();
+}
+
+void AquariumGameScene::Tick() {
+    m_aquarium->setActivityFocus(m_player->getX(), m_player->getY());
+    // Player vs NPCs and power-ups, every overlap of this tick
+    DetectPlayerContacts(m_aquarium, m_player, m_contacts);
+    // Every fish counts as 1 against the player's power and score; its own
+    // value only drains the level population
+    const int value = 1;
+    for (CreatureHandle npc : m_contacts.creatures) {
+        m_events.push(GameEvent(GameEventType::COLLISION, npc, m_player->getX(), m_player->getY(), value));
+        if (m_player->getPower() < value) {
+            m_player->loseLife(3 * 60);
+            if (m_player->getLives() <= 0) {
+                m_gameOver = true;
+                m_events.push(GameEvent(GameEventType::GAME_OVER, npc, m_player->getX(), m_player->getY()));
+                return;
             }
+        } else {
+            m_aquarium->removeCreature(npc);
+            m_events.push(GameEvent(GameEventType::CREATURE_REMOVED, npc, m_player->getX(), m_player->getY(), value));
+            m_player->addToScore(1, value);
+            if (m_player->getScore() % 25 == 0) m_player->increasePower(1);
         }
+    }
 
-        // Player vs PowerUp
-        auto powerUp = DetectPowerUpCollision(m_aquarium, m_player);
-        if (powerUp) {
-            m_player->increasePower(1);
-            m_player->startFlash();
-            m_aquarium->removePowerUp(powerUp);
-        }
+    for (const auto &powerUp : m_contacts.powerUps) {
+        m_player->increasePower(1);
+        m_player->startFlash();
+        m_aquarium->removePowerUp(powerUp);
+    }
 
-        // Update world
-        m_aquarium->update();
+    // Update world
+    int level = m_aquarium->getLevelIndex();
+    m_aquarium->update();
+    if (m_aquarium->getLevelIndex() != level) {
+        m_events.push(GameEvent(GameEventType::NEW_LEVEL, CreatureHandle(), 0.0f, 0.0f, m_aquarium->getLevelIndex()));
     }
 }
 
+bool AquariumGameScene::SaveSnapshot(const std::string& path) const {
+    SnapshotWriter out(kAquariumSnapshotVersion);
+    m_aquarium->saveSnapshot(out);
+    m_player->saveSnapshot(out);
+    return out.save(path);
+}
+
+bool AquariumGameScene::LoadSnapshot(const std::string& path) {
+    SnapshotReader in;
+    return in.load(path) && LoadSnapshot(in);
+}
+
+bool AquariumGameScene::LoadSnapshot(const SnapshotReader& in) {
+    // the player loads into a copy first, so either both sides change or neither
+    PlayerCreature player(*m_player);
+    if (!player.loadSnapshot(in) || !m_aquarium->loadSnapshot(in)) return false;
+    *m_player = player;
+    // the snapshot may come from a world of another size
+    m_player->setBounds(m_aquarium->getWidth() - 20, m_aquarium->getHeight() - 20);
+    m_gameOver = m_player->getLives() <= 0;
+    return true;
+}
+
 void AquariumGameScene::Draw() {
-    m_player->draw();
-    m_aquarium->draw();
-    paintAquariumHUD();
+    // the world scrolls under the player, the HUD stays in window coordinates
+    float alpha = m_playerClock.alpha();
+    m_camera.setViewport(ofGetWindowWidth(), ofGetWindowHeight());
+    m_camera.setWorld(m_aquarium->getWidth(), m_aquarium->getHeight());
+    m_camera.follow(m_player->getDrawX(alpha), m_player->getDrawY(alpha));
+    m_camera.begin();
+    m_player->drawInterpolated(alpha);
+    m_aquarium->draw(m_worldClock.alpha(), m_camera.getView());
+    m_camera.end();
+    drawHUD();
+    FrameProfiler &profiler = FrameProfiler::instance();
+    if (profiler.isOverlayVisible()) profiler.drawOverlay(20, 90);
+}
+
+// tall enough for the lives row and the power highlight
+static const int kHudHeight = 72;
+
+void AquariumGameScene::drawHUD() {
+    AQUARIUM_PROFILE("aquarium.hud");
+    if (!m_hudCached) {
+        paintAquariumHUD();
+        return;
+    }
+    int width = ofGetWindowWidth();
+    if (!m_hudFbo.isAllocated() || static_cast<int>(m_hudFbo.getWidth()) != width) {
+        m_hudFbo.allocate(width, kHudHeight, GL_RGBA);
+        m_hudRevision = -1;
+    }
+    if (m_hudRevision != m_player->getStatsRevision()) {
+        m_hudFbo.begin();
+        ofClear(0, 0, 0, 0);
+        paintAquariumHUD();
+        m_hudFbo.end();
+        m_hudRevision = m_player->getStatsRevision();
+    }
+    // the FBO holds premultiplied colour (see paintAquariumHUD), so blend it
+    // in once rather than scaling it by alpha a second time
+    ofSetColor(ofColor::white);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    m_hudFbo.draw(0, 0);
+    ofEnableAlphaBlending();
 }
 
 void AquariumGameScene::paintAquariumHUD() {
@@ -474,27 +1557,59 @@ void AquariumGameScene::paintAquariumHUD() {
         ofDrawCircle(panelX + i * 20.0f, 50.0f, 5.0f);
     }
     ofSetColor(ofColor::white);
+    // Same colour as alpha blending, but alpha adds up once, so painted into
+    // the cleared HUD FBO the translucent box leaves premultiplied colour.
+    // Set here because bitmap text resets the blend function.
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     ofDrawBitmapStringHighlight("Power: " + std::to_string(m_player->getPower()), 20, 60,
                                 ofColor(0,0,0,120), ofColor::yellow);
+    ofEnableAlphaBlending();
+}
+
+std::shared_ptr<AquariumGameScene> CreateAquariumGame(int width, int height,
+                                                      std::shared_ptr<AquariumSpriteManager> sprites,
+                                                      uint64_t seed, int playerSpeed, std::string name) {
+    auto aquarium = std::make_shared<Aquarium>(width, height, sprites);
+    aquarium->setSeed(seed);
+    // regions only kick in once the world is bigger than about two windows
+    aquarium->setActivityRadii(1024.0f, 4096.0f);
+    aquarium->setFlocking(true);
+    aquarium->setIslandSleep(true);
+
+    auto player = std::make_shared<PlayerCreature>(width / 2 - 50, height / 2 - 50, playerSpeed,
+                                                   sprites->GetSprite(AquariumCreatureType::NPCreature));
+    player->setFlashSprite(sprites->GetFlashSprite());
+    player->setDirection(0, 0); // Initially stationary
+    player->setBounds(width - 20, height - 20);
+
+    aquarium->addAquariumLevel(std::make_shared<Level_0>(0, 10));
+    aquarium->addAquariumLevel(std::make_shared<Level_1>(1, 15));
+    aquarium->addAquariumLevel(std::make_shared<Level_2>(2, 20));
+    aquarium->addAquariumLevel(std::make_shared<Level_3>(3, 25)); // Fast fish appear
+    aquarium->addAquariumLevel(std::make_shared<Level_4>(4, 30));
+    aquarium->Repopulate(); // initial population
+    aquarium->flushSpawns();
+
+    return std::make_shared<AquariumGameScene>(std::move(player), std::move(aquarium), std::move(name));
 }
 
-std::vector<AquariumCreatureType> Level_0::Repopulate() {
-    return RepopulateFromNodes(m_levelPopulation);
+void Level_0::Repopulate(std::vector<AquariumCreatureType>& out) {
+    RepopulateFromNodes(m_levelPopulation, out);
 }
 
-std::vector<AquariumCreatureType> Level_1::Repopulate() {
-    return RepopulateFromNodes(m_levelPopulation);
+void Level_1::Repopulate(std::vector<AquariumCreatureType>& out) {
+    RepopulateFromNodes(m_levelPopulation, out);
 }
 
-std::vector<AquariumCreatureType> Level_2::Repopulate() {
-    return RepopulateFromNodes(m_levelPopulation);
+void Level_2::Repopulate(std::vector<AquariumCreatureType>& out) {
+    RepopulateFromNodes(m_levelPopulation, out);
 }
 
-std::vector<AquariumCreatureType> Level_3::Repopulate() {
-    return RepopulateFromNodes(m_levelPopulation);
+void Level_3::Repopulate(std::vector<AquariumCreatureType>& out) {
+    RepopulateFromNodes(m_levelPopulation, out);
 }
 
-std::vector<AquariumCreatureType> Level_4::Repopulate() {
-    return RepopulateFromNodes(m_levelPopulation);
+void Level_4::Repopulate(std::vector<AquariumCreatureType>& out) {
+    RepopulateFromNodes(m_levelPopulation, out);
 }
 
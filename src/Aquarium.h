@@ -17,9 +17,50 @@ enum class AquariumCreatureType {
     FastFish,
     ArmoredFish
 };
+const int kAquariumCreatureTypeCount = 4;
 
 std::string AquariumCreatureTypeToString(AquariumCreatureType t);
 
+// ---------------- CREATURE TRAITS ----------------
+// Schooling rules per creature type. Fish align with and close in on fish of
+// their own type, keep their distance from every fish, and turn away from fish
+// of the other size class, so big and small schools stay apart.
+struct AquariumFlockingRules {
+    float radius;     // neighbours farther away are ignored
+    float separation; // away from any fish closer than the two collision radii
+    float alignment;  // toward the average heading of the school
+    float cohesion;   // toward the centre of the school
+    float avoidance;  // away from fish of the other size class
+};
+
+// What the per-creature loops need to know about a type, so they index one
+// table instead of branching on it. A new fish type adds its row here, in
+// enum order; the static_assert catches a missing one.
+struct AquariumCreatureTraits {
+    float speedScale; // multiplies the fish's speed every step
+    int sizeClass;    // 0 small, 1 big
+    AquariumFlockingRules flocking;
+};
+
+// Small fish school tightly and scatter from big ones, big fish roam loosely
+inline constexpr AquariumCreatureTraits kAquariumCreatureTraits[] = {
+    /* NPCreature  */ {1.0f, 0, {90.0f, 1.0f, 0.10f, 0.04f, 1.0f}},
+    /* BiggerFish  */ {0.5f, 1, {160.0f, 1.0f, 0.06f, 0.03f, 0.6f}},
+    /* FastFish    */ {1.0f, 0, {90.0f, 1.0f, 0.15f, 0.03f, 1.0f}},
+    /* ArmoredFish */ {1.0f, 1, {160.0f, 1.0f, 0.06f, 0.03f, 0.6f}},
+};
+static_assert(sizeof(kAquariumCreatureTraits) / sizeof(kAquariumCreatureTraits[0]) == kAquariumCreatureTypeCount,
+              "every creature type needs a row in kAquariumCreatureTraits");
+
+inline const AquariumCreatureTraits& AquariumCreatureTraitsOf(AquariumCreatureType t) {
+    return kAquariumCreatureTraits[static_cast<int>(t)];
+}
+// Per-type multiplier applied to a creature's speed when it moves
+inline float AquariumCreatureSpeedScale(AquariumCreatureType t) { return AquariumCreatureTraitsOf(t).speedScale; }
+inline const AquariumFlockingRules& AquariumFlockingRulesFor(AquariumCreatureType t) { return AquariumCreatureTraitsOf(t).flocking; }
+// 0 for small fish, 1 for BiggerFish and ArmoredFish
+inline int AquariumCreatureSizeClass(AquariumCreatureType t) { return AquariumCreatureTraitsOf(t).sizeClass; }
+
 // ---------------- LEVEL POPULATION NODE ----------------
 class AquariumLevelPopulationNode {
 public:
@@ -32,6 +73,21 @@ public:
     int currentPopulation;
 };
 
+// ---------------- SNAPSHOT SECTIONS ----------------
+// Sections of an aquarium snapshot (see SnapshotWriter). Bump the version when
+// a record changes; creature columns take one section each from CREATURES on.
+const uint32_t kAquariumSnapshotVersion = 3;
+enum class AquariumSnapshotSection : uint32_t {
+    WORLD = 1,
+    LEVELS,
+    LEVEL_NODES,
+    POWER_UPS,
+    SPAWN_QUEUE,
+    NEXT_LEVEL_SPAWNS,
+    PLAYER,
+    CREATURES = 64
+};
+
 // Forward declarations
 class AquariumLevel;
 class PowerUp;
@@ -47,8 +103,12 @@ public:
     bool isCompleted() override;
     void populationReset();
     void levelReset() { m_level_score = 0; this->populationReset(); }
-    virtual std::vector<AquariumCreatureType> Repopulate();
-
+    // Appends the creatures needed to refill the level to `out`
+    virtual void Repopulate(std::vector<AquariumCreatureType>& out);
+    int getMaxPopulation() const;
+    int getLevelScore() const { return m_level_score; }
+    void setLevelScore(int score) { m_level_score = score; }
+    const std::vector<std::shared_ptr<AquariumLevelPopulationNode>>& getPopulation() const { return m_levelPopulation; }
 
 protected:
     std::vector<std::shared_ptr<AquariumLevelPopulationNode>> m_levelPopulation;
@@ -57,6 +117,11 @@ protected:
 };
 
 // ---------------- PLAYER CREATURE ----------------
+// Pixels per step of the player's fish, in the game and in replays
+const int kAquariumPlayerSpeed = 5;
+// Default world ticks per second of AquariumGameScene
+const double kAquariumWorldTickRate = 10.0;
+
 class PlayerCreature : public Creature {
 public:
     PlayerCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
@@ -64,10 +129,13 @@ public:
     // Direction helpers
     bool isXDirectionActive() const { return m_dx != 0; }
     bool isYDirectionActive() const { return m_dy != 0; }
-    void setFlipped(bool f) { m_flipped = f; }
 
     void move() override;
     void draw() const override;
+    // Draw between the previous and current step, alpha in [0, 1]
+    void drawInterpolated(float alpha) const;
+    float getDrawX(float alpha) const { return m_prevX + (m_x - m_prevX) * alpha; }
+    float getDrawY(float alpha) const { return m_prevY + (m_y - m_prevY) * alpha; }
     void update();
     void setDirection(float dx, float dy);
     void changeSpeed(int speed);
@@ -76,33 +144,44 @@ public:
     int getScore() const { return m_score; }
     int getLives() const { return m_lives; }
     int getPower() const { return m_power; }
+    // Bumped whenever score, power or lives change, so the HUD knows when to redraw
+    int getStatsRevision() const { return m_statsRevision; }
     float getDx() const { return m_dx; }
     float getDy() const { return m_dy; }
 
     // Gameplay
-    void addToScore(int amount, int weight = 1) { m_score += amount * weight; }
-    void setLives(int lives) { m_lives = lives; }
+    void addToScore(int amount, int weight = 1) { m_score += amount * weight; ++m_statsRevision; }
+    void setLives(int lives) { m_lives = lives; ++m_statsRevision; }
     void loseLife(int debounce);
     void increasePower(int value);
     void reduceDamageDebounce();
     void startFlash();
+    void setFlashSprite(std::shared_ptr<GameSprite> sprite) { m_flashSprite = std::move(sprite); }
+
+    void saveSnapshot(SnapshotWriter& out) const;
+    bool loadSnapshot(const SnapshotReader& in);
 
 private:
     int m_score = 0;
     int m_lives = 3;
     int m_power = 1;
+    int m_statsRevision = 0;
     int m_damage_debounce = 0;
     int m_flashFrames = 0;
+    float m_prevX = 0.0f;
+    float m_prevY = 0.0f;
 
-    bool m_flipped = false;
     std::shared_ptr<GameSprite> m_flashSprite;
 };
 
 // ---------------- NPC CREATURE BASE ----------------
 class NPCreature : public Creature {
 public:
-    NPCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    AquariumCreatureType GetType() { return m_creatureType; }
+    // The direction is normalized; spawns roll it from the aquarium's generator
+    NPCreature(float x, float y, int speed, float dx, float dy, std::shared_ptr<GameSprite> sprite);
+    // Every fish type starts from this collision radius and only grows it
+    static constexpr float kBaseRadius = 30.0f;
+    AquariumCreatureType GetType() const { return m_creatureType; }
     int getValue() const { return m_value; }
     void move() override;
     void draw() const override;
@@ -115,7 +194,7 @@ protected:
 // ---------------- BIGGER FISH ----------------
 class BiggerFish : public NPCreature {
 public:
-    BiggerFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
+    BiggerFish(float x, float y, int speed, float dx, float dy, std::shared_ptr<GameSprite> sprite);
     void move() override;
     void draw() const override;
 };
@@ -123,7 +202,7 @@ public:
 // ---------------- FAST FISH ----------------
 class FastFish : public NPCreature {
 public:
-    FastFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
+    FastFish(float x, float y, int speed, float dx, float dy, std::shared_ptr<GameSprite> sprite);
     void move() override;
     void draw() const override;
 };
@@ -131,107 +210,562 @@ public:
 // ---------------- ARMORED FISH ----------------
 class ArmoredFish : public NPCreature {
 public:
-    ArmoredFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
+    ArmoredFish(float x, float y, int speed, float dx, float dy, std::shared_ptr<GameSprite> sprite);
     void move() override;
     void draw() const override;
 };
 
+// ---------------- POWERUP ----------------
+class PowerUp : public Creature {
+public:
+    enum class Type { SPEED, POWER, SIZE };
+
+    PowerUp(float x, float y, Type type, std::shared_ptr<GameSprite> sprite)
+        : Creature(x, y, 0, 20.0f, 0, sprite), m_type(type) {}
+
+    void move() override;
+    void draw() const override;
+    Type getType() const { return m_type; }
+    // drawn with (x, y) as its top-left corner
+    const std::shared_ptr<GameSprite>& getSprite() const { return m_sprite; }
+
+private:
+    Type m_type;
+};
+
 // ---------------- SPRITE MANAGER ----------------
 class AquariumSpriteManager {
 public:
     AquariumSpriteManager();
+    // Sprites start empty and are filled by the loader as their images finish
+    explicit AquariumSpriteManager(AssetLoader& loader);
     ~AquariumSpriteManager() = default;
 
+    // Shared per type, never copied; callers pick the flip when drawing
     std::shared_ptr<GameSprite> GetSprite(AquariumCreatureType t);
+    // Loaded once with the fish sprites, a missing file leaves a placeholder
+    std::shared_ptr<GameSprite> GetPowerUpSprite(PowerUp::Type t);
+    // White silhouette the player flashes with
+    std::shared_ptr<GameSprite> GetFlashSprite() { return m_flash_fish; }
 
 private:
+    void load(AssetLoader* loader);
+
     std::shared_ptr<GameSprite> m_npc_fish;
     std::shared_ptr<GameSprite> m_big_fish;
     std::shared_ptr<GameSprite> m_fast_fish;
     std::shared_ptr<GameSprite> m_armored_fish;
+    std::shared_ptr<GameSprite> m_flash_fish;
+    std::shared_ptr<GameSprite> m_speed_powerup;
+    std::shared_ptr<GameSprite> m_power_powerup;
+    std::shared_ptr<GameSprite> m_size_powerup;
 };
 
-// ---------------- POWERUP ----------------
-class PowerUp : public Creature {
+// ---------------- CREATURE STORE ----------------
+// NPC creatures kept by value as parallel arrays so the per-tick loops walk
+// packed memory instead of chasing one heap object per fish. Row i of every
+// column describes the same creature. Rows stay packed: removal moves the last
+// row into the hole, and handles go through a slot table to find the new row.
+struct AquariumCreatureStore {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> prevX; // position before the last tick, for interpolated drawing
+    std::vector<float> prevY;
+    std::vector<float> dx;
+    std::vector<float> dy;
+    std::vector<float> step; // distance per tick, speed times the type's speed scale
+    std::vector<float> radius;
+    std::vector<int> value;
+    std::vector<AquariumCreatureType> type;
+    std::vector<int> spriteId;
+    std::vector<int> born; // aquarium tick the creature spawned on, for the fade-in
+    std::vector<int> rest; // ticks in a row its contact island has been at rest, see Aquarium::setIslandSleep
+
+    CreatureHandle add(const NPCreature& creature, int sprite, int bornTick = 0);
+    // Constant time, the order of the remaining rows is not kept
+    void remove(CreatureHandle h);
+    void clear();
+    void reserve(size_t n);
+    size_t size() const { return x.size(); }
+    size_t capacity() const { return x.capacity(); }
+    bool contains(CreatureHandle h) const { return rowOf(h) >= 0; }
+    // Current row of a live creature, -1 for empty or stale handles
+    int rowOf(CreatureHandle h) const {
+        if (!h.isValid() || static_cast<size_t>(h.index) >= m_slotRow.size()) return -1;
+        return m_slotGeneration[h.index] == h.generation ? m_slotRow[h.index] : -1;
+    }
+    CreatureHandle handleAt(size_t row) const {
+        int slot = m_rowSlot[row];
+        return CreatureHandle{slot, m_slotGeneration[slot]};
+    }
+
+    // Every public column in a fixed order, for snapshots
+    template <typename Fn>
+    void forEachDataColumn(Fn&& fn) {
+        fn(x); fn(y); fn(prevX); fn(prevY); fn(dx); fn(dy);
+        fn(step); fn(radius); fn(value); fn(type); fn(spriteId); fn(born); fn(rest);
+    }
+    template <typename Fn>
+    void forEachDataColumn(Fn&& fn) const {
+        fn(x); fn(y); fn(prevX); fn(prevY); fn(dx); fn(dy);
+        fn(step); fn(radius); fn(value); fn(type); fn(spriteId); fn(born); fn(rest);
+    }
+    // Gives every row a slot again after the columns were filled directly;
+    // handles taken before go stale
+    void rebuildSlots();
+
+private:
+    template <typename Fn>
+    void forEachColumn(Fn&& fn) {
+        forEachDataColumn(fn);
+        fn(m_rowSlot);
+    }
+    int acquireSlot();
+
+    std::vector<int> m_rowSlot;             // slot of each row
+    std::vector<int> m_slotRow;             // row of each slot, -1 while free
+    std::vector<unsigned> m_slotGeneration; // bumped every time the slot is freed
+    std::vector<int> m_freeSlots;
+};
+
+// ---------------- MOVE KERNELS ----------------
+// Integration plus wall bounce over a slice of the store, eight fish at a time
+// on SSE/AVX2. All kernels give bit-identical results; Aquarium picks the best
+// one the CPU supports at runtime.
+enum class AquariumMoveKernel { SCALAR, SSE, AVX2 };
+
+std::string AquariumMoveKernelToString(AquariumMoveKernel k);
+bool AquariumMoveKernelSupported(AquariumMoveKernel k);
+AquariumMoveKernel AquariumBestMoveKernel();
+// stepScale, if given, holds one multiplier per row of the store
+void AquariumMoveCreatures(AquariumCreatureStore& s, size_t begin, size_t end,
+                           float maxX, float maxY, AquariumMoveKernel kernel,
+                           const float* stepScale = nullptr);
+
+// ---------------- FLOCKING ----------------
+// Sums the neighbours of one fish, passed in any order through add(), into a
+// new heading. Reads the store only, so many fish can be steered in parallel.
+class AquariumFlockSteering {
 public:
-    enum class Type { SPEED, POWER, SIZE };
+    AquariumFlockSteering(const AquariumCreatureStore& s, int self);
+
+    void add(int other) {
+        if (other == m_self) return;
+        float ox = m_store.x[other] - m_x;
+        float oy = m_store.y[other] - m_y;
+        float d2 = ox * ox + oy * oy;
+        if (d2 > m_radius2 || d2 == 0.0f) return;
+        AquariumCreatureType type = m_store.type[other];
+        bool school = type == m_type;
+        bool avoid = !school && AquariumCreatureSizeClass(type) != m_sizeClass;
+        if (school) {
+            m_headingX += m_store.dx[other];
+            m_headingY += m_store.dy[other];
+            m_centreX += ox;
+            m_centreY += oy;
+            ++m_school;
+        }
+        // most neighbours are schoolmates at a distance, they need no sqrt
+        float keepOut = m_selfRadius + m_store.radius[other];
+        if (!avoid && d2 >= keepOut * keepOut) return;
+        float d = std::sqrt(d2);
+        float push = avoid ? m_rules.avoidance * (1.0f - d * m_invRadius) : 0.0f;
+        if (d < keepOut) push += m_rules.separation * (1.0f - d / keepOut);
+        push /= d;
+        m_awayX -= ox * push;
+        m_awayY -= oy * push;
+    }
+    // Unit heading, the current one if nothing steers the fish
+    void result(float& dx, float& dy) const;
+    float radius() const { return m_rules.radius; }
 
-    PowerUp(float x, float y, Type type, std::shared_ptr<GameSprite> sprite)
-        : Creature(x, y, 0, 20.0f, 0, sprite), m_type(type) {}
+private:
+    const AquariumCreatureStore& m_store;
+    AquariumFlockingRules m_rules;
+    AquariumCreatureType m_type;
+    int m_sizeClass;
+    int m_self;
+    float m_x, m_y;
+    float m_selfRadius;
+    float m_radius2;
+    float m_invRadius;
+    float m_headingX = 0.0f, m_headingY = 0.0f;
+    float m_centreX = 0.0f, m_centreY = 0.0f; // relative to the fish
+    float m_awayX = 0.0f, m_awayY = 0.0f;
+    int m_school = 0;
+};
 
-    void move() override;
-    void draw() const override;
-    Type getType() const { return m_type; }
+// ---------------- SPATIAL GRID ----------------
+// Uniform grid broadphase for creature-vs-creature collisions. Cells are as wide
+// as the largest collision diameter in the tank, so any overlapping pair is in
+// the same or a neighbouring cell. Rebuilt every tick with a counting sort.
+class AquariumSpatialGrid {
+public:
+    void rebuild(const AquariumCreatureStore& creatures, int width, int height);
+    // Room for this many creatures in a width x height tank, so rebuilds up
+    // to it don't allocate while no creature is smaller than minRadius
+    void reserve(size_t creatures, int width, int height, float minRadius);
+
+    // Creature indices grouped by cell, cells in row-major order, so any
+    // slice of this list covers one band of the tank
+    const std::vector<int>& entries() const { return m_cellEntries; }
+
+    // Calls fn(j) for every creature in the 3x3 block of cells around (x, y)
+    template <typename Fn>
+    void forEachNeighbor(float x, float y, Fn&& fn) const {
+        int cell = cellOf(x, y);
+        int cx = cell % m_cols;
+        int cy = cell / m_cols;
+        for (int gy = std::max(cy - 1, 0); gy <= std::min(cy + 1, m_rows - 1); ++gy) {
+            for (int gx = std::max(cx - 1, 0); gx <= std::min(cx + 1, m_cols - 1); ++gx) {
+                int c = gy * m_cols + gx;
+                for (int e = m_cellStart[c]; e < m_cellStart[c + 1]; ++e) fn(m_cellEntries[e]);
+            }
+        }
+    }
+
+    // Calls fn(j) for every creature in the cells overlapping the box
+    template <typename Fn>
+    void forEachInBox(float minX, float minY, float maxX, float maxY, Fn&& fn) const {
+        int first = cellOf(minX, minY);
+        int last = cellOf(maxX, maxY);
+        for (int gy = first / m_cols; gy <= last / m_cols; ++gy) {
+            for (int gx = first % m_cols; gx <= last % m_cols; ++gx) {
+                int c = gy * m_cols + gx;
+                for (int e = m_cellStart[c]; e < m_cellStart[c + 1]; ++e) fn(m_cellEntries[e]);
+            }
+        }
+    }
+
+    // Twice the largest creature radius at the last rebuild
+    float cellSize() const { return m_cellSize; }
 
 private:
-    Type m_type;
+    int cellOf(float x, float y) const;
+
+    float m_cellSize = 1.0f;
+    int m_cols = 1;
+    int m_rows = 1;
+    std::vector<int> m_cellStart;    // m_cols * m_rows + 1 offsets into m_cellEntries
+    std::vector<int> m_cellEntries;  // creature indices grouped by cell
+    std::vector<int> m_creatureCell; // cell of each creature at rebuild time
+};
+
+// Overlapping pair found against the positions at the start of the collision
+// pass: the normal points from b to a, (1, 0) for fish on the same spot, and
+// `push` is half the overlap. The solver measures the overlap again every round.
+struct AquariumContact {
+    int a;
+    int b;
+    float nx;
+    float ny;
+    float push;
+};
+
+// Everything overlapping the player in one tick. Keep one instance around so
+// the queries reuse its capacity instead of allocating.
+struct AquariumPlayerContacts {
+    std::vector<CreatureHandle> creatures;
+    std::vector<std::shared_ptr<PowerUp>> powerUps;
+    void clear() { creatures.clear(); powerUps.clear(); }
+};
+
+// A queued fish, rolled from the aquarium's generator when it was queued
+struct AquariumSpawn {
+    AquariumCreatureType type;
+    int x;
+    int y;
+    int speed;
+    float dx;
+    float dy;
+};
+
+// ---------------- CAMERA ----------------
+// Window-sized view into a world that can be larger than the window. The view
+// follows a point but stops at the world's edges; a world smaller than the
+// view is centred in it.
+class AquariumCamera {
+public:
+    void setViewport(float width, float height) { m_view.width = width; m_view.height = height; }
+    void setWorld(float width, float height) { m_worldWidth = width; m_worldHeight = height; }
+    void follow(float x, float y);
+    // World rectangle currently on screen
+    const ofRectangle& getView() const { return m_view; }
+    // Everything drawn between begin() and end() is in world coordinates
+    void begin() const;
+    void end() const;
+
+private:
+    ofRectangle m_view;
+    float m_worldWidth = 0.0f;
+    float m_worldHeight = 0.0f;
 };
 
 // ---------------- AQUARIUM ----------------
 class Aquarium {
 public:
     Aquarium(int width, int height, std::shared_ptr<AquariumSpriteManager> spriteManager);
-    void addCreature(std::shared_ptr<Creature> creature);
+    CreatureHandle addCreature(const NPCreature& creature);
     void addAquariumLevel(std::shared_ptr<AquariumLevel> level);
-    void removeCreature(std::shared_ptr<Creature> creature);
+    void removeCreature(CreatureHandle creature);
     void clearCreatures();
     void update();
-    void draw() const;
+    // alpha interpolates between the previous and current tick positions
+    void draw(float alpha = 1.0f) const;
+    // Only what overlaps `view` (world coordinates) is sent to the GPU
+    void draw(float alpha, const ofRectangle& view) const;
+    // Creatures the last draw sent to the GPU
+    int getDrawnCount() const { return m_drawnCount; }
+
+    // Batched drawing sends one mesh per sprite instead of one draw per fish
+    void setBatchedDraw(bool batched) { m_batchedDraw = batched; }
+    bool isBatchedDraw() const { return m_batchedDraw; }
 
     void setBounds(int w, int h) { m_width = w; m_height = h; }
     void setMaxPopulation(int n) { m_maxPopulation = n; }
-
+    // Threads used by update(), including the caller. Results do not depend on it.
+    void setWorkerThreads(int threads) { m_workers = std::make_unique<WorkerPool>(std::max(1, threads)); }
+    int getWorkerThreads() const { return m_workers->size(); }
+    void setMoveKernel(AquariumMoveKernel kernel) { if (AquariumMoveKernelSupported(kernel)) m_moveKernel = kernel; }
+    AquariumMoveKernel getMoveKernel() const { return m_moveKernel; }
+    // Activity regions: the tank is split into kActivityRegionSize squares.
+    // Fish in regions within nearRadius of the focus move and collide every
+    // tick; up to farRadius they do so every kDistantInterval ticks with steps
+    // that much longer, staggered by region; farther out they sleep until the
+    // focus comes closer. Fish are never removed, so level populations stay
+    // exact. nearRadius <= 0 (the default) updates every fish every tick.
+    void setActivityRadii(float nearRadius, float farRadius) { m_nearRadius = nearRadius; m_farRadius = farRadius; }
+    void setActivityFocus(float x, float y) { m_focusX = x; m_focusY = y; }
+    // Fish that moved in the last update
+    int getAwakeCount() const { return m_awakeCount; }
+    // Schooling (see AquariumFlockingRules) before every move, neighbours from the grid
+    void setFlocking(bool flocking) { m_flocking = flocking; }
+    bool isFlocking() const { return m_flocking; }
+    static constexpr int kActivityRegionSize = 256;
+    static constexpr int kDistantInterval = 4;
+    static constexpr int kSteerInterval = 2;
+    // Contact solver: overlapping fish are grouped into islands and each island
+    // is relaxed for up to this many rounds, fewer once its overlaps are gone
+    void setSolverIterations(int iterations) { m_solverIterations = std::max(1, iterations); }
+    int getSolverIterations() const { return m_solverIterations; }
+    // Islands whose fish all stayed within kRestDistance of where they were for
+    // kSleepTicks ticks in a row, and fish touching nothing that did, stop
+    // moving, steering and looking for contacts until an awake fish touches
+    // them. Off by default.
+    void setIslandSleep(bool sleep) { m_islandSleep = sleep; }
+    bool isIslandSleep() const { return m_islandSleep; }
+    // Contacts and contact islands solved and fish asleep in the last update
+    int getContactCount() const { return static_cast<int>(m_contactList.size()); }
+    int getIslandCount() const { return m_islandCount; }
+    int getSleepingCount() const { return m_sleepingCount; }
+    static constexpr int kSleepTicks = 30;
+    static constexpr float kRestDistance = 0.5f;
+    static constexpr float kContactSlop = 0.01f;
+
+    // Every spawn position, speed and direction comes from this seed
+    void setSeed(uint64_t seed) { m_random.setSeed(seed); }
+    uint64_t getSeed() const { return m_random.getSeed(); }
+
+    // Queues the fish the level is missing and spawns up to the spawn budget.
+    // The next level's fish are rolled while the current one is played, so a
+    // level change only swaps queues.
     void Repopulate();
+    // Fish taken from the spawn queue per tick, 0 spawns the whole queue at once
+    void setSpawnBudget(int spawnsPerTick) { m_spawnBudget = std::max(0, spawnsPerTick); }
+    int getSpawnBudget() const { return m_spawnBudget; }
+    int getPendingSpawns() const { return static_cast<int>(m_spawnQueue.size() - m_spawnHead); }
+    // Spawns everything still queued, e.g. right after the initial Repopulate()
+    void flushSpawns();
+    // New fish fade in over this many ticks; only the drawing, they can be touched right away
+    static constexpr int kSpawnFadeTicks = 20;
+    // Spawns immediately, bypassing the queue
     void SpawnCreature(AquariumCreatureType type);
     void SpawnPowerUp(PowerUp::Type type);
     void removePowerUp(std::shared_ptr<PowerUp> powerUp);
 
-    std::shared_ptr<Creature> getCreatureAt(int i);
+    // Appends every creature and power-up overlapping the circle to `out`,
+    // creatures through the spatial grid. Handles stay valid while the
+    // caller removes some of them.
+    void queryContacts(float x, float y, float radius, AquariumPlayerContacts& out);
+
+    const AquariumCreatureStore& getCreatures() const { return m_creatures; }
     int getCreatureCount() const { return m_creatures.size(); }
+    int getLevelIndex() const { return currentLevel; }
+    // Times a spawn found the creature store full and had to reallocate it
+    int getPoolGrowths() const { return m_poolGrowths; }
     int getWidth() const { return m_width; }
     int getHeight() const { return m_height; }
     const std::vector<std::shared_ptr<PowerUp>>& GetPowerUps() const { return m_powerUps; }
 
+    // Creatures, power-ups, level progress, spawn queues and the generator.
+    // Levels are not stored, only their progress: load into an aquarium set
+    // up with the same levels. Sprites come back from the manager by type.
+    void saveSnapshot(SnapshotWriter& out) const;
+    bool loadSnapshot(const SnapshotReader& in);
+
 private:
     int m_maxPopulation = 0;
     int m_width, m_height;
     int currentLevel = 0;
 
-    std::vector<std::shared_ptr<Creature>> m_creatures;
+    int spriteIdFor(AquariumCreatureType type);
+    AquariumSpawn rollSpawn(AquariumCreatureType type);
+    void spawn(const AquariumSpawn& spawn);
+    void spawnQueued(int budget);
+    void prepareNextLevel();
+    float spawnFade(size_t row, float alpha) const;
+    void updateActivity();
+    void steerCreatures();
+    void moveCreatures();
+    void resolveCollisions();
+    void buildIslands();
+    void relaxIslands();
+    void respondToContacts();
+    void drawBatched(float alpha, const ofRectangle& view) const;
+    void drawUnbatched(float alpha, const ofRectangle& view) const;
+
+    // Removed fish leave their rows' memory behind for the next spawn and a
+    // level change keeps the store's capacity, so the store doubles as the
+    // creature pool. It is reserved for the largest level up front.
+    AquariumCreatureStore m_creatures;
+    std::vector<AquariumCreatureType> m_spawnTypes; // reused by Repopulate
+    std::vector<AquariumSpawn> m_spawnQueue;        // consumed from m_spawnHead
+    size_t m_spawnHead = 0;
+    std::vector<AquariumSpawn> m_nextLevelSpawns;
+    bool m_nextLevelReady = false;
+    int m_spawnBudget = 4;
+    int m_tick = 0;
+    int m_poolGrowths = 0;
+    Random m_random;
     std::vector<std::shared_ptr<AquariumLevel>> m_aquariumlevels;
     std::vector<std::shared_ptr<PowerUp>> m_powerUps;
     std::shared_ptr<AquariumSpriteManager> m_sprite_manager;
+    std::vector<std::shared_ptr<GameSprite>> m_sprites; // indexed by creature sprite id
+
+    bool m_batchedDraw = true;
+    mutable std::vector<ofVboMesh> m_spriteBatches; // one quad mesh per sprite id, rebuilt every draw
+    mutable int m_drawnCount = 0;
+
+    std::unique_ptr<WorkerPool> m_workers = std::make_unique<WorkerPool>();
+    AquariumMoveKernel m_moveKernel = AquariumBestMoveKernel();
+    AquariumSpatialGrid m_grid;
+    bool m_gridDirty = true; // rows changed since the last rebuild
+    float m_gridShift = 0.0f; // furthest any fish moved since the last rebuild
+
+    float m_nearRadius = 0.0f;
+    float m_farRadius = 0.0f;
+    float m_focusX = 0.0f;
+    float m_focusY = 0.0f;
+    bool m_regionsActive = false;      // set by updateActivity() for this tick
+    bool m_stepScaleActive = false;    // regions or sleeping islands, m_stepScale is valid
+    std::vector<float> m_regionScale;  // step scale of each region this tick
+    std::vector<float> m_stepScale;    // per creature row, from its region, 0 while its island sleeps
+    int m_awakeCount = 0;
+
+    bool m_flocking = false;
+    std::vector<float> m_steerDx; // new headings, copied over the store's after the pass
+    std::vector<float> m_steerDy;
+    std::vector<std::vector<AquariumContact>> m_bandContacts; // contacts found per band of grid entries
+    std::vector<int> m_contactStart;   // per creature offsets into m_contactRefs
+    std::vector<int> m_contactRefs;    // contact ids touching each creature, in band order
+    std::vector<const AquariumContact*> m_contactList;
+
+    int m_solverIterations = 3;
+    bool m_islandSleep = false;
+    int m_islandCount = 0;
+    int m_sleepingCount = 0;
+    std::vector<int> m_islandParent;       // union-find over rows, the lowest row is the root
+    std::vector<int> m_bodyIsland;         // per row, -1 outside any island
+    std::vector<int> m_contactIsland;      // per entry of m_contactList
+    std::vector<int> m_islandBodyStart;    // per island offsets into m_islandBodies
+    std::vector<int> m_islandBodies;       // rows, grouped by island in row order
+    std::vector<int> m_islandContactStart; // per island offsets into m_islandContacts
+    std::vector<int> m_islandContacts;     // indices into m_contactList, grouped by island
+    std::vector<char> m_islandSettled;     // no overlap left above kContactSlop this tick
+    std::vector<float> m_islandDepth;      // deepest overlap of each island in the current round
+    std::vector<float> m_contactPushX;     // per contact, measured in the current round
+    std::vector<float> m_contactPushY;
+    std::vector<float> m_contactOverlap;   // 0 once the pair no longer overlaps
 };
 
 // ---------------- COLLISION FUNCTIONS ----------------
-std::shared_ptr<GameEvent> DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player);
-std::shared_ptr<PowerUp> DetectPowerUpCollision(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player);
+// Fills `out` with everything the player touches this tick, without allocating
+void DetectPlayerContacts(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player,
+                          AquariumPlayerContacts& out);
 
 // ---------------- GAME SCENE ----------------
 class AquariumGameScene : public GameScene {
 public:
     AquariumGameScene(std::shared_ptr<PlayerCreature> player, std::shared_ptr<Aquarium> aquarium, std::string name);
 
-    std::shared_ptr<GameEvent> GetLastEvent() { return m_lastEvent; }
+    // Filled by Tick(), dispatched by the app once per frame
+    GameEventQueue& GetEvents() { return m_events; }
+    bool IsGameOver() const { return m_gameOver; }
     std::shared_ptr<PlayerCreature> GetPlayer() { return m_player; }
     std::shared_ptr<Aquarium> GetAquarium() { return m_aquarium; }
+    // Follows the player over the aquarium, sized to the window every draw
+    const AquariumCamera& GetCamera() const { return m_camera; }
     std::string GetName() override { return m_name; }
 
     void Update() override;
     void Draw() override;
+    // The ambient loop only plays while the scene is active
+    void OnEnter() override;
+    void OnExit() override;
+    // Update() for a given frame time, so a recorded session can be replayed
+    void Advance(double frameSeconds);
+    // Frame time the next Update() advances by instead of the clock's
+    void SetFrameTime(double frameSeconds) { m_frameTime = frameSeconds; }
+    // One simulation step: player collisions, then the aquarium update
+    void Tick();
+    // Arrow key presses and releases, applied right away
+    void HandleInput(const InputCommand& command);
+
+    // Whole game state between two ticks, see Aquarium::saveSnapshot()
+    bool SaveSnapshot(const std::string& path) const;
+    bool LoadSnapshot(const std::string& path);
+    bool LoadSnapshot(const SnapshotReader& in);
+
+    // The HUD is drawn into a layer that is only repainted when the player's
+    // stats change; uncached it is painted from scratch every frame
+    void setHudCached(bool cached) { m_hudCached = cached; }
+    bool isHudCached() const { return m_hudCached; }
+
+    // Aquarium ticks per second, independent of the display frame rate
+    void setTickRate(double ticksPerSecond) { m_worldClock.setTickRate(ticksPerSecond); }
+    double getTickRate() const { return m_worldClock.getTickRate(); }
 
 private:
+    void drawHUD();
     void paintAquariumHUD();
 
     std::shared_ptr<PlayerCreature> m_player;
     std::shared_ptr<Aquarium> m_aquarium;
-    std::shared_ptr<GameEvent> m_lastEvent;
+    GameEventQueue m_events;
+    bool m_gameOver = false;
+    AquariumPlayerContacts m_contacts; // reused every tick
 
     std::string m_name;
-    AwaitFrames updateControl{5};
+    // the player keeps the 60 Hz steps it was tuned for, the aquarium used to
+    // tick every sixth frame at 60 fps so it defaults to 10 Hz
+    FixedTimestep m_playerClock{60.0, 8};
+    FixedTimestep m_worldClock{kAquariumWorldTickRate, 4};
+    double m_frameTime = -1.0; // from SetFrameTime(), used once
+    AquariumCamera m_camera;
     ofSoundPlayer m_ambientSound;
+
+    ofFbo m_hudFbo;
+    int m_hudRevision = -1; // player stats revision the layer shows
+    bool m_hudCached = true;
 };
 
+// The game as ofApp sets it up: Level_0 to Level_4 and the player in the
+// middle of the tank. Replays build the world with it too, so a recorded
+// session meets the same fish.
+std::shared_ptr<AquariumGameScene> CreateAquariumGame(int width, int height,
+                                                      std::shared_ptr<AquariumSpriteManager> sprites,
+                                                      uint64_t seed, int playerSpeed, std::string name);
+
 // ---------------- LEVELS ----------------
 class Level_0 : public AquariumLevel {
 public:
@@ -239,7 +773,7 @@ public:
         m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(
             AquariumCreatureType::NPCreature, 10));
     }
-    std::vector<AquariumCreatureType> Repopulate() override;
+    void Repopulate(std::vector<AquariumCreatureType>& out) override;
 };
 
 class Level_1 : public AquariumLevel {
@@ -248,7 +782,7 @@ public:
         m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(
             AquariumCreatureType::NPCreature, 20));
     }
-    std::vector<AquariumCreatureType> Repopulate() override;
+    void Repopulate(std::vector<AquariumCreatureType>& out) override;
 };
 
 class Level_2 : public AquariumLevel {
@@ -259,7 +793,7 @@ public:
         m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(
             AquariumCreatureType::BiggerFish, 5));
     }
-    std::vector<AquariumCreatureType> Repopulate() override;
+    void Repopulate(std::vector<AquariumCreatureType>& out) override;
 };
 
 class Level_3 : public AquariumLevel {
@@ -272,7 +806,7 @@ public:
         m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(
             AquariumCreatureType::FastFish, 5));
     }
-    std::vector<AquariumCreatureType> Repopulate() override;
+    void Repopulate(std::vector<AquariumCreatureType>& out) override;
 };
 
 class Level_4 : public AquariumLevel {
@@ -287,5 +821,5 @@ public:
         m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(
             AquariumCreatureType::ArmoredFish, 5));
     }
-    std::vector<AquariumCreatureType> Repopulate() override;
+    void Repopulate(std::vector<AquariumCreatureType>& out) override;
 };
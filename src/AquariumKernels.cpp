@@ -0,0 +1,154 @@
+#include "Aquarium.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AQUARIUM_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// Integration and wall bounce for a range of the creature store. Every kernel
+// performs the same float operations in the same order as the scalar one
+// (multiply, then add, no FMA), so they agree bit for bit. The store already
+// holds each fish's step with its type's speed scale applied, so every type
+// runs through the same lanes. An optional per-fish step scale multiplies the
+// step last; a scale of 1 leaves it bit-identical.
+
+namespace {
+
+void MoveScalar(AquariumCreatureStore& s, size_t begin, size_t end, float maxX, float maxY, const float* stepScale) {
+    for (size_t i = begin; i < end; ++i) {
+        s.prevX[i] = s.x[i];
+        s.prevY[i] = s.y[i];
+        float step = s.step[i];
+        if (stepScale) step *= stepScale[i];
+        s.x[i] += s.dx[i] * step;
+        s.y[i] += s.dy[i] * step;
+        if (s.x[i] < 0)    { s.x[i] = 0;    s.dx[i] = std::abs(s.dx[i]); }
+        if (s.x[i] > maxX) { s.x[i] = maxX; s.dx[i] = -std::abs(s.dx[i]); }
+        if (s.y[i] < 0)    { s.y[i] = 0;    s.dy[i] = std::abs(s.dy[i]); }
+        if (s.y[i] > maxY) { s.y[i] = maxY; s.dy[i] = -std::abs(s.dy[i]); }
+    }
+}
+
+#ifdef AQUARIUM_X86_KERNELS
+
+// Clamp p into [0, max] and point d back inside, same order as the scalar code
+inline void BounceSSE(__m128& p, __m128& d, __m128 max) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 low = _mm_cmplt_ps(p, zero);
+    p = _mm_andnot_ps(low, p);
+    d = _mm_or_ps(_mm_and_ps(low, _mm_andnot_ps(sign, d)), _mm_andnot_ps(low, d));
+    __m128 high = _mm_cmpgt_ps(p, max);
+    p = _mm_or_ps(_mm_and_ps(high, max), _mm_andnot_ps(high, p));
+    d = _mm_or_ps(_mm_and_ps(high, _mm_or_ps(sign, d)), _mm_andnot_ps(high, d));
+}
+
+void MoveSSE(AquariumCreatureStore& s, size_t begin, size_t end, float maxX, float maxY, const float* stepScale) {
+    const __m128 vMaxX = _mm_set1_ps(maxX);
+    const __m128 vMaxY = _mm_set1_ps(maxY);
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        for (size_t lane = i; lane < i + 8; lane += 4) {
+            __m128 x = _mm_loadu_ps(&s.x[lane]);
+            __m128 y = _mm_loadu_ps(&s.y[lane]);
+            __m128 dx = _mm_loadu_ps(&s.dx[lane]);
+            __m128 dy = _mm_loadu_ps(&s.dy[lane]);
+            _mm_storeu_ps(&s.prevX[lane], x);
+            _mm_storeu_ps(&s.prevY[lane], y);
+
+            __m128 step = _mm_loadu_ps(&s.step[lane]);
+            if (stepScale) step = _mm_mul_ps(step, _mm_loadu_ps(&stepScale[lane]));
+            x = _mm_add_ps(x, _mm_mul_ps(dx, step));
+            y = _mm_add_ps(y, _mm_mul_ps(dy, step));
+            BounceSSE(x, dx, vMaxX);
+            BounceSSE(y, dy, vMaxY);
+
+            _mm_storeu_ps(&s.x[lane], x);
+            _mm_storeu_ps(&s.y[lane], y);
+            _mm_storeu_ps(&s.dx[lane], dx);
+            _mm_storeu_ps(&s.dy[lane], dy);
+        }
+    }
+    MoveScalar(s, i, end, maxX, maxY, stepScale);
+}
+
+__attribute__((target("avx2")))
+inline void BounceAVX2(__m256& p, __m256& d, __m256 max) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 low = _mm256_cmp_ps(p, zero, _CMP_LT_OQ);
+    p = _mm256_blendv_ps(p, zero, low);
+    d = _mm256_blendv_ps(d, _mm256_andnot_ps(sign, d), low);
+    __m256 high = _mm256_cmp_ps(p, max, _CMP_GT_OQ);
+    p = _mm256_blendv_ps(p, max, high);
+    d = _mm256_blendv_ps(d, _mm256_or_ps(sign, d), high);
+}
+
+__attribute__((target("avx2")))
+void MoveAVX2(AquariumCreatureStore& s, size_t begin, size_t end, float maxX, float maxY, const float* stepScale) {
+    const __m256 vMaxX = _mm256_set1_ps(maxX);
+    const __m256 vMaxY = _mm256_set1_ps(maxY);
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_loadu_ps(&s.x[i]);
+        __m256 y = _mm256_loadu_ps(&s.y[i]);
+        __m256 dx = _mm256_loadu_ps(&s.dx[i]);
+        __m256 dy = _mm256_loadu_ps(&s.dy[i]);
+        _mm256_storeu_ps(&s.prevX[i], x);
+        _mm256_storeu_ps(&s.prevY[i], y);
+
+        __m256 step = _mm256_loadu_ps(&s.step[i]);
+        if (stepScale) step = _mm256_mul_ps(step, _mm256_loadu_ps(&stepScale[i]));
+        x = _mm256_add_ps(x, _mm256_mul_ps(dx, step));
+        y = _mm256_add_ps(y, _mm256_mul_ps(dy, step));
+        BounceAVX2(x, dx, vMaxX);
+        BounceAVX2(y, dy, vMaxY);
+
+        _mm256_storeu_ps(&s.x[i], x);
+        _mm256_storeu_ps(&s.y[i], y);
+        _mm256_storeu_ps(&s.dx[i], dx);
+        _mm256_storeu_ps(&s.dy[i], dy);
+    }
+    MoveScalar(s, i, end, maxX, maxY, stepScale);
+}
+
+#endif // AQUARIUM_X86_KERNELS
+
+} // namespace
+
+std::string AquariumMoveKernelToString(AquariumMoveKernel k) {
+    switch (k) {
+        case AquariumMoveKernel::SCALAR: return "scalar";
+        case AquariumMoveKernel::SSE:    return "sse";
+        case AquariumMoveKernel::AVX2:   return "avx2";
+        default:                         return "unknown";
+    }
+}
+
+bool AquariumMoveKernelSupported(AquariumMoveKernel k) {
+    switch (k) {
+        case AquariumMoveKernel::SCALAR: return true;
+#ifdef AQUARIUM_X86_KERNELS
+        case AquariumMoveKernel::SSE:    return __builtin_cpu_supports("sse2");
+        case AquariumMoveKernel::AVX2:   return __builtin_cpu_supports("avx2");
+#endif
+        default:                         return false;
+    }
+}
+
+AquariumMoveKernel AquariumBestMoveKernel() {
+    if (AquariumMoveKernelSupported(AquariumMoveKernel::AVX2)) return AquariumMoveKernel::AVX2;
+    if (AquariumMoveKernelSupported(AquariumMoveKernel::SSE)) return AquariumMoveKernel::SSE;
+    return AquariumMoveKernel::SCALAR;
+}
+
+void AquariumMoveCreatures(AquariumCreatureStore& s, size_t begin, size_t end,
+                           float maxX, float maxY, AquariumMoveKernel kernel, const float* stepScale) {
+    switch (kernel) {
+#ifdef AQUARIUM_X86_KERNELS
+        case AquariumMoveKernel::AVX2: MoveAVX2(s, begin, end, maxX, maxY, stepScale); return;
+        case AquariumMoveKernel::SSE:  MoveSSE(s, begin, end, maxX, maxY, stepScale); return;
+#endif
+        default:                       MoveScalar(s, begin, end, maxX, maxY, stepScale); return;
+    }
+}
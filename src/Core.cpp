@@ -1,4 +1,8 @@
 #include "Core.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 
 
 // Creature Inherited Base Behavior
@@ -32,6 +36,393 @@ void Creature::bounce() {
 }
 
 
+// Worker pool
+WorkerPool::WorkerPool(int threads) {
+    for (int i = 1; i < threads; ++i) {
+        m_workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &t : m_workers) t.join();
+}
+
+void WorkerPool::run(size_t count, size_t grain, ChunkFn fn, void* ctx) {
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    if (m_workers.empty() || chunks <= 1) {
+        for (size_t begin = 0; begin < count; begin += grain) fn(ctx, begin, std::min(count, begin + grain));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fn = fn;
+        m_ctx = ctx;
+        m_count = count;
+        m_grain = grain;
+        m_chunks = chunks;
+        m_nextChunk = 0;
+        m_pending = static_cast<int>(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+}
+
+void WorkerPool::runChunks() {
+    for (size_t c = m_nextChunk++; c < m_chunks; c = m_nextChunk++) {
+        size_t begin = c * m_grain;
+        m_fn(m_ctx, begin, std::min(m_count, begin + m_grain));
+    }
+}
+
+void WorkerPool::workerLoop() {
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+        runChunks();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0) m_done.notify_one();
+        }
+    }
+}
+
+
+// Frame profiler
+FrameProfiler& FrameProfiler::instance() {
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+int FrameProfiler::zone(const char* name) {
+    for (size_t i = 0; i < m_zones.size(); ++i) {
+        if (std::string(m_zones[i].name) == name) return static_cast<int>(i);
+    }
+    m_zones.push_back(Zone{name});
+    return static_cast<int>(m_zones.size()) - 1;
+}
+
+void FrameProfiler::beginFrame() {
+    auto now = std::chrono::steady_clock::now();
+    m_frameMs[m_head] = std::chrono::duration<double, std::milli>(now - m_frameStart).count();
+    m_frameStart = now;
+    for (auto &z : m_zones) {
+        z.history[m_head] = z.current;
+        z.current = 0.0;
+    }
+    m_head = (m_head + 1) % kFrames;
+    m_recorded = std::min(m_recorded + 1, kFrames);
+}
+
+FrameProfiler::ZoneStats FrameProfiler::statsOf(const std::vector<double>& history) const {
+    ZoneStats stats;
+    if (m_recorded == 0) return stats;
+    // the newest m_recorded entries, wherever the ring starts
+    m_sorted.clear();
+    for (int i = 0; i < m_recorded; ++i) m_sorted.push_back(history[(m_head - 1 - i + kFrames) % kFrames]);
+    std::sort(m_sorted.begin(), m_sorted.end());
+    double total = 0.0;
+    for (double ms : m_sorted) total += ms;
+    stats.minMs = m_sorted.front();
+    stats.maxMs = m_sorted.back();
+    stats.avgMs = total / m_sorted.size();
+    stats.p99Ms = m_sorted[static_cast<size_t>(0.99 * (m_sorted.size() - 1))];
+    return stats;
+}
+
+void FrameProfiler::drawOverlay(float x, float y) const {
+    auto line = [](const char* name, const ZoneStats& s) {
+        char text[128];
+        std::snprintf(text, sizeof(text), "%-18s %6.2f %6.2f %6.2f", name, s.minMs, s.avgMs, s.p99Ms);
+        return std::string(text);
+    };
+    ofSetColor(ofColor::white);
+    ofDrawBitmapString("zone (ms)             min    avg    p99", x, y);
+    ofDrawBitmapString(line("frame", frameStats()), x, y + 14);
+    for (size_t i = 0; i < m_zones.size(); ++i) {
+        ofDrawBitmapString(line(m_zones[i].name, zoneStats(static_cast<int>(i))), x, y + 28 + 14 * i);
+    }
+
+    // frame times, oldest on the left, 1 px per frame, 2 px per ms
+    float graphY = y + 28 + 14 * m_zones.size() + 50;
+    ofSetColor(ofColor::yellow);
+    ofDrawLine(x, graphY - 2.0f * (1000.0f / 60.0f), x + kFrames, graphY - 2.0f * (1000.0f / 60.0f));
+    ofSetColor(ofColor::white);
+    for (int i = 0; i < m_recorded; ++i) {
+        int slot = (m_head - m_recorded + i + kFrames) % kFrames;
+        float h = std::min(2.0f * static_cast<float>(m_frameMs[slot]), 100.0f);
+        ofDrawLine(x + i, graphY, x + i, graphY - h);
+    }
+}
+
+bool FrameProfiler::writeCsv(const string& path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "zone,frames,min_ms,avg_ms,p99_ms,max_ms\n";
+    auto row = [&](const char* name, const ZoneStats& s) {
+        out << name << ',' << m_recorded << ',' << s.minMs << ',' << s.avgMs << ',' << s.p99Ms << ',' << s.maxMs << '\n';
+    };
+    row("frame", frameStats());
+    for (size_t i = 0; i < m_zones.size(); ++i) row(m_zones[i].name, zoneStats(static_cast<int>(i)));
+    return static_cast<bool>(out);
+}
+
+
+// Session recording
+static const char kSessionMagic[4] = {'A', 'Q', 'R', 'S'};
+static const uint32_t kSessionVersion = 1;
+
+bool SessionRecorder::open(const string& path, uint64_t seed, int width, int height) {
+    close();
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        ofLogError() << "Cannot record session to " << path;
+        return false;
+    }
+    int32_t size[2] = {width, height};
+    std::fwrite(kSessionMagic, 1, sizeof(kSessionMagic), m_file);
+    std::fwrite(&kSessionVersion, sizeof(kSessionVersion), 1, m_file);
+    std::fwrite(&seed, sizeof(seed), 1, m_file);
+    std::fwrite(size, sizeof(size), 1, m_file);
+    return true;
+}
+
+void SessionRecorder::recordFrame(double frameSeconds, const std::vector<InputCommand>& commands) {
+    if (!m_file) return;
+    uint16_t count = static_cast<uint16_t>(std::min<size_t>(commands.size(), UINT16_MAX));
+    std::fwrite(&frameSeconds, sizeof(frameSeconds), 1, m_file);
+    std::fwrite(&count, sizeof(count), 1, m_file);
+    for (uint16_t i = 0; i < count; ++i) {
+        unsigned char command[2] = {static_cast<unsigned char>(commands[i].key),
+                                    static_cast<unsigned char>(commands[i].pressed ? 1 : 0)};
+        std::fwrite(command, 1, sizeof(command), m_file);
+    }
+}
+
+void SessionRecorder::close() {
+    if (m_file) std::fclose(m_file);
+    m_file = nullptr;
+}
+
+bool SessionReplay::open(const string& path) {
+    std::ifstream in(path, std::ios::binary);
+    m_data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    const size_t header = sizeof(kSessionMagic) + sizeof(uint32_t) + sizeof(uint64_t) + 2 * sizeof(int32_t);
+    uint32_t version = 0;
+    if (m_data.size() >= header) std::memcpy(&version, &m_data[4], sizeof(version));
+    if (m_data.size() < header || std::memcmp(m_data.data(), kSessionMagic, sizeof(kSessionMagic)) != 0 ||
+        version != kSessionVersion) {
+        ofLogError() << "Not a session recording: " << path;
+        m_data.clear();
+        return false;
+    }
+    int32_t size[2];
+    std::memcpy(&m_seed, &m_data[8], sizeof(m_seed));
+    std::memcpy(size, &m_data[16], sizeof(size));
+    m_width = size[0];
+    m_height = size[1];
+    m_cursor = header;
+    return true;
+}
+
+bool SessionReplay::nextFrame(double& frameSeconds, std::vector<InputCommand>& commands) {
+    commands.clear();
+    uint16_t count = 0;
+    if (m_cursor + sizeof(frameSeconds) + sizeof(count) > m_data.size()) return false;
+    std::memcpy(&frameSeconds, &m_data[m_cursor], sizeof(frameSeconds));
+    std::memcpy(&count, &m_data[m_cursor + sizeof(frameSeconds)], sizeof(count));
+    m_cursor += sizeof(frameSeconds) + sizeof(count);
+    if (m_cursor + 2 * count > m_data.size()) return false; // truncated file
+    for (uint16_t i = 0; i < count; ++i, m_cursor += 2) {
+        commands.push_back(InputCommand{static_cast<InputKey>(m_data[m_cursor]), m_data[m_cursor + 1] != 0});
+    }
+    return true;
+}
+
+
+// Snapshots
+static const char kSnapshotMagic[4] = {'A', 'Q', 'S', 'N'};
+static const size_t kSnapshotHeader = 16;
+static const size_t kSnapshotTableEntry = 24;
+static const size_t kSnapshotAlign = 64;
+
+static size_t AlignSnapshot(size_t offset) {
+    return (offset + kSnapshotAlign - 1) / kSnapshotAlign * kSnapshotAlign;
+}
+
+void SnapshotWriter::addBytes(uint32_t id, size_t recordSize, const void* records, size_t count) {
+    Section section{id, static_cast<uint32_t>(recordSize), count, {}};
+    const unsigned char* bytes = static_cast<const unsigned char*>(records);
+    section.bytes.assign(bytes, bytes + recordSize * count);
+    m_sections.push_back(std::move(section));
+}
+
+size_t SnapshotWriter::size() const {
+    size_t offset = kSnapshotHeader + kSnapshotTableEntry * m_sections.size();
+    for (const auto &section : m_sections) offset = AlignSnapshot(offset) + section.bytes.size();
+    return offset;
+}
+
+bool SnapshotWriter::save(const string& path) const {
+    std::vector<unsigned char> file(size(), 0);
+    uint32_t header[3] = {m_version, static_cast<uint32_t>(m_sections.size()), 0};
+    std::memcpy(&file[0], kSnapshotMagic, sizeof(kSnapshotMagic));
+    std::memcpy(&file[4], header, sizeof(header));
+
+    size_t entry = kSnapshotHeader;
+    size_t offset = kSnapshotHeader + kSnapshotTableEntry * m_sections.size();
+    for (const auto &section : m_sections) {
+        offset = AlignSnapshot(offset);
+        uint32_t ids[2] = {section.id, section.recordSize};
+        uint64_t place[2] = {section.count, offset};
+        std::memcpy(&file[entry], ids, sizeof(ids));
+        std::memcpy(&file[entry + sizeof(ids)], place, sizeof(place));
+        if (!section.bytes.empty()) std::memcpy(&file[offset], section.bytes.data(), section.bytes.size());
+        entry += kSnapshotTableEntry;
+        offset += section.bytes.size();
+    }
+
+    std::FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) {
+        ofLogError() << "Cannot write snapshot " << path;
+        return false;
+    }
+    bool written = std::fwrite(file.data(), 1, file.size(), out) == file.size();
+    return std::fclose(out) == 0 && written;
+}
+
+bool SnapshotReader::load(const string& path) {
+    // one read of the known size, snapshots can be megabytes
+    m_owned.clear();
+    if (std::FILE* in = std::fopen(path.c_str(), "rb")) {
+        std::fseek(in, 0, SEEK_END);
+        long size = std::ftell(in);
+        std::fseek(in, 0, SEEK_SET);
+        if (size > 0) {
+            m_owned.resize(static_cast<size_t>(size));
+            if (std::fread(m_owned.data(), 1, m_owned.size(), in) != m_owned.size()) m_owned.clear();
+        }
+        std::fclose(in);
+    }
+    if (!open(m_owned.data(), m_owned.size())) {
+        ofLogError() << "Not a snapshot: " << path;
+        m_owned.clear();
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::open(const unsigned char* data, size_t size) {
+    m_data = nullptr;
+    m_size = 0;
+    uint32_t header[3] = {0, 0, 0};
+    if (!data || size < kSnapshotHeader || std::memcmp(data, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) return false;
+    std::memcpy(header, data + 4, sizeof(header));
+    if ((size - kSnapshotHeader) / kSnapshotTableEntry < header[1]) return false;
+    m_data = data;
+    m_size = size;
+    m_version = header[0];
+    m_sectionCount = header[1];
+    return true;
+}
+
+const unsigned char* SnapshotReader::findBytes(uint32_t id, size_t recordSize, size_t& count) const {
+    count = 0;
+    for (uint32_t i = 0; i < m_sectionCount; ++i) {
+        const unsigned char* entry = m_data + kSnapshotHeader + i * kSnapshotTableEntry;
+        uint32_t ids[2];
+        uint64_t place[2];
+        std::memcpy(ids, entry, sizeof(ids));
+        std::memcpy(place, entry + sizeof(ids), sizeof(place));
+        if (ids[0] != id) continue;
+        // a record that changed size means a different layout, not just more data
+        if (ids[1] != recordSize || place[1] > m_size || place[0] > (m_size - place[1]) / recordSize) return nullptr;
+        count = static_cast<size_t>(place[0]);
+        return m_data + place[1];
+    }
+    return nullptr;
+}
+
+
+// Asset loader
+AssetLoader::~AssetLoader() {
+    m_cancel = true;
+    for (auto &t : m_decoders) t.join();
+}
+
+void AssetLoader::queueImage(const string& path, int width, int height, ImageCallback onLoaded) {
+    auto job = std::make_unique<Job>();
+    job->path = path;
+    job->width = width;
+    job->height = height;
+    job->onLoaded = std::move(onLoaded);
+    m_jobs.push_back(std::move(job));
+}
+
+void AssetLoader::queueStep(Step step) {
+    auto job = std::make_unique<Job>();
+    job->step = std::move(step);
+    job->decoded = true;
+    m_jobs.push_back(std::move(job));
+}
+
+std::shared_ptr<GameSprite> AssetLoader::queueSprite(const string& path, int width, int height) {
+    auto sprite = std::make_shared<GameSprite>(width, height);
+    queueImage(path, width, height, [sprite](ofPixels& pixels, bool loaded) {
+        if (loaded) sprite->setPixels(pixels);
+        else sprite->setPlaceholder();
+    });
+    return sprite;
+}
+
+void AssetLoader::start(int threads) {
+    if (threads <= 0) threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    for (int i = 0; i < threads; ++i) m_decoders.emplace_back(&AssetLoader::decodeLoop, this);
+}
+
+void AssetLoader::decodeLoop() {
+    for (size_t i = m_nextDecode++; i < m_jobs.size() && !m_cancel; i = m_nextDecode++) {
+        Job &job = *m_jobs[i];
+        if (job.step) continue;
+        job.loaded = ofLoadImage(job.pixels, job.path);
+        if (job.loaded && job.width > 0 && job.height > 0) job.pixels.resize(job.width, job.height);
+        job.decoded = true;
+    }
+}
+
+bool AssetLoader::update(double budgetMs) {
+    auto start = std::chrono::steady_clock::now();
+    while (m_finished < m_jobs.size() && m_jobs[m_finished]->decoded) {
+        Job &job = *m_jobs[m_finished];
+        if (job.step) {
+            job.step();
+        } else {
+            if (!job.loaded) ofLogError() << "Failed to load image: " << job.path;
+            if (job.onLoaded) job.onLoaded(job.pixels, job.loaded);
+            job.pixels.clear();
+        }
+        ++m_finished;
+        if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMs) break;
+    }
+    return isDone();
+}
+
+
 void GameEvent::print() const {
         
         switch (type) {
@@ -39,23 +430,23 @@ void GameEvent::print() const {
                 ofLogVerbose() << "No event." << std::endl;
                 break;
             case GameEventType::COLLISION:
-                ofLogVerbose() << "Collision event between creatures at (" 
-                << creatureA->getX() << ", " << creatureA->getY() << ") and ("
-                << creatureB->getX() << ", " << creatureB->getY() << ")." << std::endl;
+                ofLogVerbose() << "Collision event at (" << x << ", " << y << ") with creature #"
+                << npc.index << "." << std::endl;
                 break;
             case GameEventType::CREATURE_ADDED:
                 ofLogVerbose() << "Creature added at (" 
-                << creatureA->getX() << ", " << creatureA->getY() << ")." << std::endl;
+                << x << ", " << y << ")." << std::endl;
                 break;
             case GameEventType::CREATURE_REMOVED:
                 ofLogVerbose() << "Creature removed at (" 
-                << creatureA->getX() << ", " << creatureA->getY() << ")." << std::endl;
+                << x << ", " << y << ")." << std::endl;
                 break;
             case GameEventType::GAME_OVER:
                 ofLogVerbose() << "Game Over event." << std::endl;
                 break;
             case GameEventType::NEW_LEVEL:
-                ofLogVerbose() << "New Game level" << std::endl;
+                ofLogVerbose() << "New Game level " << value << std::endl;
+                break;
             default:
                 ofLogVerbose() << "Unknown event type." << std::endl;
                 break;
@@ -64,16 +455,20 @@ void GameEvent::print() const {
 
 // collision detection between two creatures
 
-bool checkCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b) {
+bool checkCollision(const std::shared_ptr<Creature>& a, const std::shared_ptr<Creature>& b) {
     if (!a || !b) return false;
+    return checkCollision(a->getX(), a->getY(), a->getCollisionRadius(),
+                          b->getX(), b->getY(), b->getCollisionRadius());
+};
 
-    float dx = a->getX() - b->getX();
-    float dy = a->getY() - b->getY();
+bool checkCollision(float ax, float ay, float aRadius, float bx, float by, float bRadius) {
+    float dx = ax - bx;
+    float dy = ay - by;
     float distanceSquared = dx * dx + dy * dy;
 
-    float combinedRadius = a->getCollisionRadius() + b->getCollisionRadius();
+    float combinedRadius = aRadius + bRadius;
     return distanceSquared <= (combinedRadius * combinedRadius);
-};
+}
 
 
 string GameSceneKindToString(GameSceneKind t){
@@ -83,40 +478,29 @@ string GameSceneKindToString(GameSceneKind t){
         case GameSceneKind::AQUARIUM_GAME: return "AQUARIUM_GAME";
         case GameSceneKind::GAME_OVER: return "GAME_OVER";
     };
+    return "UNKNOWN";
 };
 
-std::shared_ptr<GameScene> GameSceneManager::GetScene(string name){
-    if(!this->HasScenes()){return nullptr;}
-    for(std::shared_ptr<GameScene> scene : this->m_scenes){
-        if(scene->GetName() == name){
-            return scene;
-        }
-    }
-    return nullptr;
-}
-
-void GameSceneManager::Transition(string name){
-    if(!this->HasScenes()){return;} // no need to do anything if nothing inside
-    std::shared_ptr<GameScene> newScene = this->GetScene(name);
+void GameSceneManager::Transition(GameSceneKind kind){
+    std::shared_ptr<GameScene> newScene = this->GetScene(kind);
     if(newScene == nullptr){return;} // i dont have the scene so time to leave
-    if(newScene->GetName() == this->m_active_scene->GetName()){return;} // another do nothing since active scene is already pulled
+    if(newScene == this->m_active_scene){return;} // another do nothing since active scene is already pulled
+    if(this->m_active_scene){this->m_active_scene->OnExit();}
     this->m_active_scene = newScene; // now we keep it since this is a valid transition
-    return;
+    this->m_active_kind = kind;
+    this->m_active_scene->OnEnter();
 }
 
-void GameSceneManager::AddScene(std::shared_ptr<GameScene> newScene){
-    if(this->GetScene(newScene->GetName()) != nullptr){
+void GameSceneManager::AddScene(GameSceneKind kind, std::shared_ptr<GameScene> newScene){
+    if(newScene == nullptr || this->HasScene(kind)){
         return; // this scene already exist and shouldnt be added again
     }
-    this->m_scenes.push_back(newScene);
+    this->m_scenes[static_cast<int>(kind)] = newScene;
     if(m_active_scene == nullptr){
         this->m_active_scene = newScene; // need to place in active scene as its the only one in existance right now
+        this->m_active_kind = kind;
+        this->m_active_scene->OnEnter();
     }
-    return;
-}
-
-std::shared_ptr<GameScene> GameSceneManager::GetActiveScene(){
-    return this->m_active_scene;
 }
 
 string GameSceneManager::GetActiveSceneName(){
@@ -125,13 +509,14 @@ string GameSceneManager::GetActiveSceneName(){
 }
 
 void GameSceneManager::UpdateActiveScene(){
-    if(!this->HasScenes()){return;} // make sure we have a scene before we try to paint
+    AQUARIUM_PROFILE("scene.update");
+    if(this->m_active_scene == nullptr){return;} // make sure we have a scene before we try to paint
     this->m_active_scene->Update();
 
 }
 
 void GameSceneManager::DrawActiveScene(){
-    if(!this->HasScenes()){return;} // make sure we have something before Drawing it
+    if(this->m_active_scene == nullptr){return;} // make sure we have something before Drawing it
     this->m_active_scene->Draw();
 }
 
@@ -142,6 +527,17 @@ void GameIntroScene::Update(){
 
 void GameIntroScene::Draw(){
     this->m_banner->draw(0,0);
+    if(m_loader && !m_loader->isDone()){
+        float width = ofGetWindowWidth() * 0.5f;
+        float x = (ofGetWindowWidth() - width) / 2.0f;
+        float y = ofGetWindowHeight() - 60.0f;
+        ofSetColor(ofColor::white);
+        ofDrawBitmapString("Loading " + std::to_string(static_cast<int>(m_loader->progress() * 100)) + "%", x, y - 8);
+        ofNoFill();
+        ofDrawRectangle(x, y, width, 12);
+        ofFill();
+        ofDrawRectangle(x, y, width * m_loader->progress(), 12);
+    }
 }
 
 void GameOverScene::Update(){
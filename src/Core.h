@@ -1,11 +1,63 @@
+#pragma once
 #include <iostream>
 #include <memory>
 #include <utility>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#ifdef AQUARIUM_HEADLESS
+#include "HeadlessOF.h"
+#else
 #include "ofMain.h"
+#endif
 
 
+// Small seedable PRNG (PCG32). Each aquarium owns one, so a seed fixes every
+// spawn and a recorded session can be replayed exactly.
+class Random {
+public:
+	explicit Random(uint64_t seed = 1) { setSeed(seed); }
+
+	void setSeed(uint64_t seed) {
+		m_seed = seed;
+		m_state = 0;
+		next();
+		m_state += seed;
+		next();
+	}
+	uint64_t getSeed() const { return m_seed; }
+	// Raw generator state, so a snapshot continues the exact same sequence
+	uint64_t getState() const { return m_state; }
+	void restore(uint64_t seed, uint64_t state) { m_seed = seed; m_state = state; }
+
+	uint32_t next() {
+		uint64_t old = m_state;
+		m_state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+		uint32_t rot = static_cast<uint32_t>(old >> 59u);
+		return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+	}
+	// Uniform in [0, bound)
+	int nextInt(int bound) {
+		if (bound <= 1) return 0;
+		return static_cast<int>((static_cast<uint64_t>(next()) * static_cast<uint64_t>(bound)) >> 32);
+	}
+
+private:
+	uint64_t m_seed = 1;
+	uint64_t m_state = 0;
+};
+
 class AwaitFrames {
 public:
 	AwaitFrames(int frames) : m_frames(frames), m_counter(0) {}
@@ -22,38 +74,386 @@ private:
 	int m_counter;
 };
 
+// Accumulates real frame time and hands it out as fixed-size simulation steps,
+// so the simulation runs at the same rate whatever the display refresh is.
+class FixedTimestep {
+public:
+	FixedTimestep(double tickRate, int maxStepsPerFrame)
+	: m_step(1.0 / tickRate), m_maxSteps(maxStepsPerFrame), m_accumulator(0.0) {}
+
+	// Number of steps to run for a frame that took frameSeconds. Time beyond
+	// maxStepsPerFrame steps is dropped instead of snowballing into later frames.
+	int advance(double frameSeconds) {
+		m_accumulator += frameSeconds;
+		int steps = static_cast<int>(m_accumulator / m_step);
+		m_accumulator -= steps * m_step;
+		return std::min(steps, m_maxSteps);
+	}
+	// How far the current time is between the last step and the next, in [0, 1)
+	float alpha() const { return static_cast<float>(m_accumulator / m_step); }
+
+	void setTickRate(double tickRate) { m_step = 1.0 / tickRate; }
+	double getTickRate() const { return 1.0 / m_step; }
+private:
+	double m_step;
+	int m_maxSteps;
+	double m_accumulator;
+};
+
+// Fixed set of threads for data-parallel loops. The calling thread works too,
+// so a pool of size 1 has no workers and runs everything inline.
+class WorkerPool {
+public:
+	explicit WorkerPool(int threads = static_cast<int>(std::thread::hardware_concurrency()));
+	~WorkerPool();
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	int size() const { return static_cast<int>(m_workers.size()) + 1; }
+
+	// Calls fn(begin, end) for every chunk of `grain` items in [0, count) and
+	// returns once all are done. Chunk bounds depend only on count and grain,
+	// never on the thread count, so per-chunk results are reproducible.
+	template <typename Fn>
+	void parallelFor(size_t count, size_t grain, Fn&& fn) {
+		using F = typename std::remove_reference<Fn>::type;
+		run(count, grain, [](void* ctx, size_t begin, size_t end) { (*static_cast<F*>(ctx))(begin, end); }, &fn);
+	}
+
+private:
+	using ChunkFn = void (*)(void*, size_t, size_t);
+	void run(size_t count, size_t grain, ChunkFn fn, void* ctx);
+	void runChunks();
+	void workerLoop();
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	ChunkFn m_fn = nullptr;
+	void* m_ctx = nullptr;
+	size_t m_count = 0;
+	size_t m_grain = 1;
+	size_t m_chunks = 0;
+	std::atomic<size_t> m_nextChunk{0};
+	int m_pending = 0;
+	unsigned long m_generation = 0;
+	bool m_stop = false;
+};
+
+// Main-thread frame profiler. Named zones are timed with AQUARIUM_PROFILE and
+// summed per frame; the last kFrames frame totals of every zone stay in ring
+// buffers for the overlay and the CSV summary.
+class FrameProfiler {
+public:
+	static constexpr int kFrames = 240;
+
+	struct ZoneStats {
+		double minMs = 0.0;
+		double avgMs = 0.0;
+		double p99Ms = 0.0;
+		double maxMs = 0.0;
+	};
+
+	static FrameProfiler& instance();
+
+	// Registers the zone on first use; the pointer must outlive the profiler
+	int zone(const char* name);
+	void add(int zone, double ms) { m_zones[zone].current += ms; }
+	// Closes the running frame and starts the next one
+	void beginFrame();
+
+	void setEnabled(bool enabled) { m_enabled = enabled; }
+	bool isEnabled() const { return m_enabled; }
+	void setOverlayVisible(bool visible) { m_overlayVisible = visible; }
+	bool isOverlayVisible() const { return m_overlayVisible; }
+
+	// "frame" covers the whole frame, zones only their own time
+	ZoneStats frameStats() const { return statsOf(m_frameMs); }
+	ZoneStats zoneStats(int zone) const { return statsOf(m_zones[zone].history); }
+	void drawOverlay(float x, float y) const;
+	bool writeCsv(const string& path) const;
+
+private:
+	struct Zone {
+		const char* name;
+		double current = 0.0;
+		std::vector<double> history = std::vector<double>(kFrames, 0.0);
+	};
+	ZoneStats statsOf(const std::vector<double>& history) const;
+
+	std::vector<Zone> m_zones;
+	std::vector<double> m_frameMs = std::vector<double>(kFrames, 0.0);
+	mutable std::vector<double> m_sorted; // scratch for the percentiles
+	std::chrono::steady_clock::time_point m_frameStart = std::chrono::steady_clock::now();
+	int m_head = 0;       // next ring slot
+	int m_recorded = 0;   // valid frames in the rings
+	bool m_enabled = true;
+	bool m_overlayVisible = false;
+};
+
+// Adds the time until the end of the enclosing block to a profiler zone
+class ProfileScope {
+public:
+	explicit ProfileScope(int zone)
+	: m_zone(FrameProfiler::instance().isEnabled() ? zone : -1), m_start(std::chrono::steady_clock::now()) {}
+	~ProfileScope() {
+		if (m_zone < 0) return;
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+		FrameProfiler::instance().add(m_zone, elapsed.count());
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+	int m_zone;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+#define AQUARIUM_PROFILE_CAT2(a, b) a##b
+#define AQUARIUM_PROFILE_CAT(a, b) AQUARIUM_PROFILE_CAT2(a, b)
+#define AQUARIUM_PROFILE(name) \
+	static const int AQUARIUM_PROFILE_CAT(profileZone_, __LINE__) = FrameProfiler::instance().zone(name); \
+	ProfileScope AQUARIUM_PROFILE_CAT(profileScope_, __LINE__)(AQUARIUM_PROFILE_CAT(profileZone_, __LINE__))
+
+// Player input as the game sees it, independent of the keyboard layout
+enum class InputKey : uint8_t { UP, DOWN, LEFT, RIGHT };
+struct InputCommand {
+	InputKey key;
+	bool pressed;
+};
+
+// Binary session log for reproducible runs: a header with the seed and the
+// window size, then one record per game frame with the frame time and the
+// input commands applied before that frame's update.
+//   header: "AQRS" u32 version u64 seed i32 width i32 height
+//   frame:  f64 seconds u16 count, count x (u8 key, u8 pressed)
+class SessionRecorder {
+public:
+	bool open(const string& path, uint64_t seed, int width, int height);
+	bool isOpen() const { return m_file != nullptr; }
+	void recordFrame(double frameSeconds, const std::vector<InputCommand>& commands);
+	void close();
+	~SessionRecorder() { close(); }
+
+private:
+	std::FILE* m_file = nullptr;
+};
+
+class SessionReplay {
+public:
+	// Reads the whole file up front
+	bool open(const string& path);
+	uint64_t getSeed() const { return m_seed; }
+	int getWidth() const { return m_width; }
+	int getHeight() const { return m_height; }
+	// False once every frame was read
+	bool nextFrame(double& frameSeconds, std::vector<InputCommand>& commands);
+
+private:
+	std::vector<unsigned char> m_data;
+	size_t m_cursor = 0;
+	uint64_t m_seed = 0;
+	int m_width = 0;
+	int m_height = 0;
+};
+
+// Versioned container of flat binary sections, for game snapshots. Every
+// section is an array of fixed-size records starting on a 64 byte boundary,
+// so a reader can work straight off a memory-mapped file.
+//   header: "AQSN" u32 version u32 sectionCount u32 reserved
+//   table:  sectionCount x (u32 id, u32 recordSize, u64 count, u64 offset)
+// Values are stored in the machine's native (little-endian) layout.
+class SnapshotWriter {
+public:
+	explicit SnapshotWriter(uint32_t version) : m_version(version) {}
+
+	template <typename T>
+	void add(uint32_t id, const T* records, size_t count) {
+		static_assert(std::is_trivially_copyable<T>::value, "snapshot records are copied as raw bytes");
+		addBytes(id, sizeof(T), records, count);
+	}
+	template <typename T>
+	void add(uint32_t id, const std::vector<T>& records) { add(id, records.data(), records.size()); }
+
+	bool save(const string& path) const;
+	size_t size() const;
+
+private:
+	struct Section {
+		uint32_t id;
+		uint32_t recordSize;
+		uint64_t count;
+		std::vector<unsigned char> bytes;
+	};
+	void addBytes(uint32_t id, size_t recordSize, const void* records, size_t count);
+
+	uint32_t m_version;
+	std::vector<Section> m_sections;
+};
+
+class SnapshotReader {
+public:
+	SnapshotReader() = default;
+	SnapshotReader(const SnapshotReader&) = delete;
+	SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+	// Reads the whole file into memory
+	bool load(const string& path);
+	// Reads in place, e.g. a mapped file; the memory must outlive the reader
+	bool open(const unsigned char* data, size_t size);
+	uint32_t getVersion() const { return m_version; }
+	size_t size() const { return m_size; }
+
+	// Records of a section, nullptr if it is missing or its record size differs
+	template <typename T>
+	const unsigned char* find(uint32_t id, size_t& count) const {
+		static_assert(std::is_trivially_copyable<T>::value, "snapshot records are copied as raw bytes");
+		return findBytes(id, sizeof(T), count);
+	}
+	// Copies a whole section into `out`, false if it is missing or malformed
+	template <typename T>
+	bool read(uint32_t id, std::vector<T>& out) const {
+		size_t count = 0;
+		const unsigned char* bytes = find<T>(id, count);
+		if (!bytes) return false;
+		out.resize(count);
+		if (count) std::memcpy(out.data(), bytes, count * sizeof(T));
+		return true;
+	}
+	// Exactly one record
+	template <typename T>
+	bool readOne(uint32_t id, T& out) const {
+		size_t count = 0;
+		const unsigned char* bytes = find<T>(id, count);
+		if (!bytes || count != 1) return false;
+		std::memcpy(&out, bytes, sizeof(T));
+		return true;
+	}
+
+private:
+	const unsigned char* findBytes(uint32_t id, size_t recordSize, size_t& count) const;
+
+	std::vector<unsigned char> m_owned;
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+	uint32_t m_version = 0;
+	uint32_t m_sectionCount = 0;
+};
+
+class GameSprite;
+
+// Cold-start loading off the main thread. Images are decoded and resized on
+// background threads; update(), called every frame on the GL thread, hands each
+// decoded image to its callback for the texture upload and runs the queued
+// main-thread steps (fonts, sound, scene setup). Work finishes in queue order,
+// so a step can rely on every image queued before it.
+class AssetLoader {
+public:
+	using ImageCallback = std::function<void(ofPixels& pixels, bool loaded)>;
+	using Step = std::function<void()>;
+
+	AssetLoader() = default;
+	~AssetLoader();
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// Queue everything before start(). width/height <= 0 keep the file's size.
+	void queueImage(const string& path, int width, int height, ImageCallback onLoaded);
+	void queueStep(Step step);
+	// Empty sprite that fills itself (or turns into a placeholder) when its image is done
+	std::shared_ptr<GameSprite> queueSprite(const string& path, int width, int height);
+	void start(int threads = 0);
+
+	// Finishes ready work for about budgetMs; true once everything is done
+	bool update(double budgetMs = 4.0);
+	float progress() const { return m_jobs.empty() ? 1.0f : static_cast<float>(m_finished) / m_jobs.size(); }
+	bool isDone() const { return m_finished == m_jobs.size(); }
+
+private:
+	struct Job {
+		string path;
+		int width = 0;
+		int height = 0;
+		ImageCallback onLoaded;
+		Step step;
+		ofPixels pixels;
+		bool loaded = false;
+		std::atomic<bool> decoded{false};
+	};
+	void decodeLoop();
+
+	std::vector<std::unique_ptr<Job>> m_jobs;
+	std::vector<std::thread> m_decoders;
+	std::atomic<size_t> m_nextDecode{0};
+	std::atomic<bool> m_cancel{false};
+	size_t m_finished = 0;
+};
+
+// Loaded once per image and shared by every creature drawing it. The mirrored
+// copy is built up front so flipping is a per-draw choice, not sprite state.
 class GameSprite {
 public:
     GameSprite(const std::string& imagePath, int width, int height)
     : m_width(width), m_height(height) {
         if (!m_image.load(imagePath)) {
             std::cerr << "Failed to load image: " << imagePath << std::endl;
+            setPlaceholder();
+            return;
         }
         m_image.resize(width, height);
         m_flippedImage = m_image;
         m_flippedImage.mirror(false, true); // Mirror horizontally
+        m_ready = true;
     }
+    // Empty until setPixels() or setPlaceholder(), for sprites filled by an AssetLoader
+    GameSprite(int width, int height) : m_width(width), m_height(height) {}
+    GameSprite(const GameSprite&) = delete;
+    GameSprite& operator=(const GameSprite&) = delete;
+
     int width() const { return getWidth(); }
     int height() const { return getHeight(); }
 
-    void draw(float x, float y) const {
-        if (m_flipped) {
+    // Uploads pixels already decoded at the sprite size, GL thread only
+    void setPixels(ofPixels& pixels) {
+        m_image.setFromPixels(pixels);
+        pixels.mirror(false, true);
+        m_flippedImage.setFromPixels(pixels);
+        m_ready = true;
+    }
+    // Solid fill so a missing asset is obvious on screen
+    void setPlaceholder() {
+        m_image.allocate(m_width, m_height, OF_IMAGE_COLOR_ALPHA);
+        m_image.setColor(ofColor::magenta);
+        m_image.update();
+        m_flippedImage = m_image;
+        m_placeholder = true;
+        m_ready = true;
+    }
+
+    void draw(float x, float y, bool flipped = false) const {
+        if (!m_ready) return;
+        if (flipped) {
             m_flippedImage.draw(x, y);
         } else {
             m_image.draw(x, y);
         }
     }
 
-    void setFlipped(bool flipped) { m_flipped = flipped; }
     int getWidth() const { return m_width; }
     int getHeight() const { return m_height; }
+    // True when the image file could not be loaded
+    bool isPlaceholder() const { return m_placeholder; }
+    bool isReady() const { return m_ready; }
+    // Unmirrored texture, batched draws flip through the texture coordinates
+    const ofTexture& getTexture() const { return m_image.getTexture(); }
 
 private:
     ofImage m_image;
     ofImage m_flippedImage;
       int m_width;
     int m_height; 
-    bool m_flipped = false;
+    bool m_placeholder = false;
+    bool m_ready = false;
 };
 
 
@@ -82,6 +482,7 @@ protected:
     float m_height = 0.0f;
     float m_collisionRadius = 0.0f;
     int m_value = 0;
+    bool m_flipped = false;
     std::shared_ptr<GameSprite> m_sprite;
 
 public:
@@ -96,11 +497,8 @@ public:
     float getY() const { return m_y; }
     int getSpeed() const { return m_speed; }
     void setSpeed(int speed) { m_speed = speed; }
-    void setFlipped(bool flipped) {
-        if (m_sprite) {
-            m_sprite->setFlipped(flipped);
-        }
-    }
+    void setFlipped(bool flipped) { m_flipped = flipped; }
+    bool isFlipped() const { return m_flipped; }
     void setSprite(std::shared_ptr<GameSprite> sprite) { m_sprite = std::move(sprite); }
     int getValue() const { return m_value; }
 
@@ -116,6 +514,15 @@ public:
     float getDy() const { return m_dy; }
 };
 
+// Slot of a creature kept by value in a packed creature store. The slot stays
+// put while the creature's row moves; the generation changes when the creature
+// is removed, so an old handle can never reach the fish that reuses the slot.
+struct CreatureHandle {
+    int index = -1;
+    unsigned generation = 0;
+    bool isValid() const { return index >= 0; }
+};
+
 // GameEvents
 enum class GameEventType {
     NONE,
@@ -127,17 +534,18 @@ enum class GameEventType {
     NEW_LEVEL,
 };
 
+// Plain data so events can be queued by value: creatures are named by handle
+// and position, never owned.
 class GameEvent {
     public:
-    GameEventType type;
-    std::shared_ptr<Creature> creatureA;
-    std::shared_ptr<Creature> creatureB; // For collision events
-    GameEvent() : type(GameEventType::NONE), creatureA(nullptr), creatureB(nullptr) {}
-    GameEvent(GameEventType t, std::shared_ptr<Creature> a , std::shared_ptr<Creature> b){
-        type = t;
-        creatureA = a;
-        creatureB = b;
-    }
+    GameEventType type = GameEventType::NONE;
+    CreatureHandle npc; // store-held creature involved, if any
+    float x = 0.0f;     // where it happened
+    float y = 0.0f;
+    int value = 0;      // points for collisions and removals, level for NEW_LEVEL
+    GameEvent() = default;
+    GameEvent(GameEventType t, CreatureHandle n = CreatureHandle(), float px = 0.0f, float py = 0.0f, int v = 0)
+    : type(t), npc(n), x(px), y(py), value(v) {}
     
     // Additional methods can be added here
     bool isCollisionEvent() const { return type == GameEventType::COLLISION; }
@@ -145,16 +553,65 @@ class GameEvent {
     bool isCreatureRemovedEvent() const { return type == GameEventType::CREATURE_REMOVED; }
     bool isGameOver() const { return type == GameEventType::GAME_OVER; }
     bool isGameExit() const { return type == GameEventType::GAME_EXIT; }
+    bool isNewLevel() const { return type == GameEventType::NEW_LEVEL; }
     bool isNoneEvent() const { return type == GameEventType::NONE; }
     
     // i want a printable representation of the event, with the creature descriptions if available
     void print() const;
 };
+static_assert(std::is_trivially_copyable<GameEvent>::value, "GameEvent is queued by value");
 
+// Fixed-capacity FIFO of events, filled while the simulation ticks and
+// dispatched to the subscribers once per frame. The ring is allocated once;
+// pushing and dispatching never allocate. A push into a full queue is refused
+// and counted in dropped(), the default holds a whole tank eaten in one frame.
+class GameEventQueue {
+public:
+    using Listener = std::function<void(const GameEvent&)>;
 
+    explicit GameEventQueue(int capacity = 4096) : m_events(std::max(1, capacity)) {}
 
+    bool push(const GameEvent& event) {
+        if (m_size == capacity()) { ++m_dropped; return false; }
+        m_events[(m_head + m_size) % capacity()] = event;
+        ++m_size;
+        return true;
+    }
+    bool pop(GameEvent& out) {
+        if (m_size == 0) return false;
+        out = m_events[m_head];
+        m_head = (m_head + 1) % capacity();
+        --m_size;
+        return true;
+    }
+    int size() const { return m_size; }
+    int capacity() const { return static_cast<int>(m_events.size()); }
+    bool empty() const { return m_size == 0; }
+    unsigned long dropped() const { return m_dropped; }
+
+    // Subscribe while setting up, listeners are called in subscription order
+    void subscribe(Listener listener) { m_listeners.push_back(std::move(listener)); }
+    // Hands every queued event to each listener, oldest first, and empties the queue
+    void dispatch() {
+        GameEvent event;
+        while (pop(event)) {
+            for (auto &listener : m_listeners) listener(event);
+        }
+    }
 
-bool checkCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b);
+private:
+    std::vector<GameEvent> m_events;
+    int m_head = 0;
+    int m_size = 0;
+    unsigned long m_dropped = 0;
+    std::vector<Listener> m_listeners;
+};
+
+
+
+
+bool checkCollision(const std::shared_ptr<Creature>& a, const std::shared_ptr<Creature>& b);
+bool checkCollision(float ax, float ay, float aRadius, float bx, float by, float bRadius);
 
 
 class GameLevel {
@@ -177,6 +634,10 @@ class GameScene {
         virtual string GetName() = 0;
         virtual void Update() = 0;
         virtual void Draw() = 0;
+        // Called by GameSceneManager when the scene becomes active or stops
+        // being active, to acquire or release what only the active scene needs
+        virtual void OnEnter() {}
+        virtual void OnExit() {}
         virtual ~GameScene() = default;
 
 };
@@ -186,19 +647,22 @@ enum class GameSceneKind {
     AQUARIUM_GAME,
     GAME_OVER
 };
+const int kGameSceneKindCount = 3;
 
 string GameSceneKindToString(GameSceneKind t);
 
 class GameIntroScene : public GameScene {
     public:
-        GameIntroScene(string name, std::shared_ptr<GameSprite> banner)
-        : m_name(name), m_banner(std::move(banner)){};
+        // With a loader, a progress bar is drawn until it is done
+        GameIntroScene(string name, std::shared_ptr<GameSprite> banner, std::shared_ptr<AssetLoader> loader = nullptr)
+        : m_name(name), m_banner(std::move(banner)), m_loader(std::move(loader)){};
         string GetName() override {return this->m_name;}
         void Update() override;
         void Draw() override;
     private:
         string m_name;
         std::shared_ptr<GameSprite> m_banner;
+        std::shared_ptr<AssetLoader> m_loader;
 };
 
 class GameOverScene : public GameScene {
@@ -214,13 +678,18 @@ class GameOverScene : public GameScene {
 };
 
 
+// One slot per GameSceneKind, so lookups and transitions are an array index
 class GameSceneManager {
     public:
-        void Transition(string name);
-        void AddScene(std::shared_ptr<GameScene> newScene);
-        bool HasScenes(){return m_scenes.size() > 0; }
-        std::shared_ptr<GameScene> GetScene(string name);
-        std::shared_ptr<GameScene> GetActiveScene();
+        // Ignored if the kind already has a scene; the first scene becomes active
+        void AddScene(GameSceneKind kind, std::shared_ptr<GameScene> newScene);
+        // Runs the exit hook of the old scene and the enter hook of the new one
+        void Transition(GameSceneKind kind);
+        bool HasScene(GameSceneKind kind) const { return m_scenes[static_cast<int>(kind)] != nullptr; }
+        bool IsActive(GameSceneKind kind) const { return m_active_scene && m_active_kind == kind; }
+        GameSceneKind GetActiveKind() const { return m_active_kind; }
+        std::shared_ptr<GameScene> GetScene(GameSceneKind kind) const { return m_scenes[static_cast<int>(kind)]; }
+        std::shared_ptr<GameScene> GetActiveScene() const { return m_active_scene; }
         
         // support the functionality
         string GetActiveSceneName();
@@ -228,7 +697,8 @@ class GameSceneManager {
         void DrawActiveScene();
 
     private:
-        std::vector<std::shared_ptr<GameScene>> m_scenes;
+        std::shared_ptr<GameScene> m_scenes[kGameSceneKindCount];
         std::shared_ptr<GameScene> m_active_scene;
+        GameSceneKind m_active_kind = GameSceneKind::GAME_INTRO;
 
 };
\ No newline at end of file
@@ -0,0 +1,182 @@
+#pragma once
+
+// Null stand-ins for the parts of openFrameworks the simulation core touches.
+// Only used when building with AQUARIUM_HEADLESS (see bench/), so Aquarium,
+// Creature and the collision code can run without a window or GL context.
+// Loading succeeds without touching the disk and every draw is a no-op.
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::string;
+
+typedef unsigned int ofIndexType;
+
+#define GL_STREAM_DRAW 0x88E0
+#define GL_RGBA 0x1908
+#define GL_ONE 1
+#define GL_SRC_ALPHA 0x0302
+#define GL_ONE_MINUS_SRC_ALPHA 0x0303
+
+namespace glm {
+struct vec2 {
+    float x = 0.0f, y = 0.0f;
+    vec2() = default;
+    vec2(float x_, float y_) : x(x_), y(y_) {}
+};
+struct vec3 {
+    float x = 0.0f, y = 0.0f, z = 0.0f;
+    vec3() = default;
+    vec3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+};
+}
+
+class ofColor {
+public:
+    ofColor(int r = 0, int g = 0, int b = 0, int a = 255) : r(r), g(g), b(b), a(a) {}
+    int r, g, b, a;
+    static const ofColor red, white, yellow, black, magenta;
+};
+inline const ofColor ofColor::red(255, 0, 0);
+inline const ofColor ofColor::white(255, 255, 255);
+inline const ofColor ofColor::yellow(255, 255, 0);
+inline const ofColor ofColor::black(0, 0, 0);
+inline const ofColor ofColor::magenta(255, 0, 255);
+
+struct ofFloatColor {
+    float r, g, b, a;
+    ofFloatColor(float r = 1.0f, float g = 1.0f, float b = 1.0f, float a = 1.0f) : r(r), g(g), b(b), a(a) {}
+};
+
+struct ofRectangle {
+    float x = 0.0f, y = 0.0f, width = 0.0f, height = 0.0f;
+    ofRectangle() = default;
+    ofRectangle(float x_, float y_, float w, float h) : x(x_), y(y_), width(w), height(h) {}
+};
+
+class ofPixels {
+public:
+    void resize(int, int) {}
+    void mirror(bool, bool) {}
+    void clear() {}
+};
+
+inline bool ofLoadImage(ofPixels&, const std::string&) { return true; }
+
+class ofTexture {
+public:
+    glm::vec2 getCoordFromPercent(float x, float y) const { return glm::vec2(x, y); }
+    void bind() const {}
+    void unbind() const {}
+};
+
+enum ofImageType { OF_IMAGE_GRAYSCALE, OF_IMAGE_COLOR, OF_IMAGE_COLOR_ALPHA };
+
+class ofImage {
+public:
+    bool load(const std::string&) { return true; }
+    void allocate(int, int, ofImageType) {}
+    void setColor(const ofColor&) {}
+    void update() {}
+    void setFromPixels(const ofPixels&) {}
+    bool isAllocated() const { return true; }
+    void resize(int, int) {}
+    void mirror(bool, bool) {}
+    void draw(float, float) const {}
+    const ofTexture& getTexture() const { return m_texture; }
+private:
+    ofTexture m_texture;
+};
+
+enum ofPrimitiveMode { OF_PRIMITIVE_TRIANGLES };
+
+class ofVboMesh {
+public:
+    void clear() { m_vertices = 0; }
+    void setMode(ofPrimitiveMode) {}
+    void setUsage(int) {}
+    void addVertex(const glm::vec3&) { ++m_vertices; }
+    void addTexCoord(const glm::vec2&) {}
+    void addColor(const ofFloatColor&) {}
+    void addIndex(ofIndexType) {}
+    size_t getNumVertices() const { return m_vertices; }
+    void draw() const {}
+private:
+    size_t m_vertices = 0;
+};
+
+class ofFbo {
+public:
+    void allocate(int width, int height, int = GL_RGBA) { m_width = width; m_height = height; m_allocated = true; }
+    bool isAllocated() const { return m_allocated; }
+    float getWidth() const { return static_cast<float>(m_width); }
+    float getHeight() const { return static_cast<float>(m_height); }
+    void begin() {}
+    void end() {}
+    void draw(float, float) const {}
+private:
+    int m_width = 0;
+    int m_height = 0;
+    bool m_allocated = false;
+};
+
+class ofSoundPlayer {
+public:
+    bool load(const std::string&, bool = false) { return true; }
+    void setLoop(bool) {}
+    void setVolume(float) {}
+    void play() {}
+    void stop() {}
+};
+
+// Verbose and notice logs are dropped, warnings and errors go to stderr
+class ofHeadlessLog {
+public:
+    explicit ofHeadlessLog(bool enabled) : m_enabled(enabled) {}
+    template <typename T>
+    ofHeadlessLog& operator<<(const T& value) {
+        if (m_enabled) std::cerr << value;
+        return *this;
+    }
+    ofHeadlessLog& operator<<(std::ostream& (*manip)(std::ostream&)) {
+        if (m_enabled) std::cerr << manip;
+        return *this;
+    }
+    ~ofHeadlessLog() { if (m_enabled) std::cerr << std::endl; }
+private:
+    bool m_enabled;
+};
+struct ofLogVerbose : ofHeadlessLog { ofLogVerbose() : ofHeadlessLog(false) {} };
+struct ofLogNotice : ofHeadlessLog { ofLogNotice() : ofHeadlessLog(false) {} };
+struct ofLogWarning : ofHeadlessLog { ofLogWarning() : ofHeadlessLog(true) {} };
+struct ofLogError : ofHeadlessLog { ofLogError() : ofHeadlessLog(true) {} };
+
+enum ofBlendMode { OF_BLENDMODE_ADD };
+
+inline void ofPushStyle() {}
+inline void ofPopStyle() {}
+inline void ofPushMatrix() {}
+inline void ofPopMatrix() {}
+inline void ofTranslate(float, float, float = 0.0f) {}
+inline void ofEnableBlendMode(ofBlendMode) {}
+inline void ofDisableBlendMode() {}
+inline void ofEnableAlphaBlending() {}
+inline void glBlendFunc(unsigned, unsigned) {}
+inline void glBlendFuncSeparate(unsigned, unsigned, unsigned, unsigned) {}
+inline void ofSetColor(const ofColor&) {}
+inline void ofSetColor(int, int, int, int = 255) {}
+inline void ofDrawCircle(float, float, float) {}
+inline void ofDrawRectangle(float, float, float, float) {}
+inline void ofNoFill() {}
+inline void ofDrawLine(float, float, float, float) {}
+inline void ofFill() {}
+inline void ofDrawBitmapString(const std::string&, float, float) {}
+inline void ofDrawBitmapStringHighlight(const std::string&, float, float,
+                                        const ofColor& = ofColor(0), const ofColor& = ofColor(255)) {}
+inline void ofClear(int, int, int, int) {}
+inline void ofBackgroundGradient(const ofColor&, const ofColor&) {}
+inline double ofGetLastFrameTime() { return 1.0 / 60.0; }
+inline int ofGetWindowWidth() { return 1024; }
+inline int ofGetWindowHeight() { return 768; }
@@ -2,7 +2,7 @@
 #include "ofApp.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char** argv){
 
 	//Use ofGLFWWindowSettings for more options like multi-monitor fullscreen
 	ofGLWindowSettings settings;
@@ -11,7 +11,19 @@ int main( ){
 
 	auto window = ofCreateWindow(settings);
 
-	ofRunApp(window, std::make_shared<ofApp>());
+	// --record FILE saves the session, --replay FILE plays one back, --seed N fixes the fish,
+	// --world-width/--world-height size the tank independently of the window
+	auto app = std::make_shared<ofApp>();
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		if (arg == "--record") app->recordPath = argv[i + 1];
+		else if (arg == "--replay") app->replayPath = argv[i + 1];
+		else if (arg == "--seed") app->sessionSeed = std::strtoull(argv[i + 1], nullptr, 10);
+		else if (arg == "--world-width") app->worldWidth = std::atoi(argv[i + 1]);
+		else if (arg == "--world-height") app->worldHeight = std::atoi(argv[i + 1]);
+	}
+
+	ofRunApp(window, app);
 	ofRunMainLoop();
 
 }
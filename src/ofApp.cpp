@@ -1,142 +1,198 @@
 #include "ofApp.h"
 #include "Aquarium.h" 
 
+// Arrow keys steer the player, everything else is not game input
+static bool ToInputKey(int key, InputKey& out){
+    switch(key){
+        case OF_KEY_UP:    out = InputKey::UP;    return true;
+        case OF_KEY_DOWN:  out = InputKey::DOWN;  return true;
+        case OF_KEY_LEFT:  out = InputKey::LEFT;  return true;
+        case OF_KEY_RIGHT: out = InputKey::RIGHT; return true;
+        default:           return false;
+    }
+}
+
 //--------------------------------------------------------------
 void ofApp::setup(){
 
     ofSetFrameRate(60);
     ofSetBackgroundColor(ofColor::blue);
-    backgroundImage.load("background.png");
-    backgroundImage.resize(ofGetWindowWidth(), ofGetWindowHeight());
 
+    // a replay brings its own seed and tank size, a fresh run picks a seed;
+    // the tank is as big as the window unless --world-width/--world-height say otherwise
+    if(worldWidth <= 0) worldWidth = ofGetWindowWidth();
+    if(worldHeight <= 0) worldHeight = ofGetWindowHeight();
+    if(!replayPath.empty() && replay.open(replayPath)){
+        replaying = true;
+        sessionSeed = replay.getSeed();
+        worldWidth = replay.getWidth();
+        worldHeight = replay.getHeight();
+        ofLogNotice() << "Replaying " << replayPath << " with seed " << sessionSeed;
+    } else if(sessionSeed == 0){
+        sessionSeed = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    }
 
-    std::shared_ptr<Aquarium> myAquarium;
-    std::shared_ptr<PlayerCreature> player;
+    // every asset is decoded in the background and uploaded over the first
+    // frames, the intro scene shows the progress meanwhile
+    assetLoader = std::make_shared<AssetLoader>();
+    int width = ofGetWindowWidth();
+    int height = ofGetWindowHeight();
+    auto titleBanner = assetLoader->queueSprite("title.png", width, height);
+    assetLoader->queueImage("background.png", width, height, [this](ofPixels& pixels, bool loaded) {
+        if (loaded) backgroundImage.setFromPixels(pixels);
+    });
+    spriteManager = std::make_shared<AquariumSpriteManager>(*assetLoader);
+    auto gameOverBanner = assetLoader->queueSprite("game-over.png", width, height);
+
+    // Load font for game over message
+    assetLoader->queueStep([this] {
+        gameOverTitle.load("Verdana.ttf", 12, true, true);
+        gameOverTitle.setLineHeight(34.0f);
+        gameOverTitle.setLetterSpacing(1.035);
+    });
+    // the game scene uses the sprites above, so it is set up last
+    assetLoader->queueStep([this] { setupAquariumScene(); });
 
     // make the game scene manager 
     gameManager = std::make_unique<GameSceneManager>();
 
-
     // first we make the intro scene 
-    gameManager->AddScene(std::make_shared<GameIntroScene>(
-        GameSceneKindToString(GameSceneKind::GAME_INTRO),
-        std::make_shared<GameSprite>("title.png", ofGetWindowWidth(), ofGetWindowHeight())
+    gameManager->AddScene(GameSceneKind::GAME_INTRO, std::make_shared<GameIntroScene>(
+        GameSceneKindToString(GameSceneKind::GAME_INTRO), titleBanner, assetLoader
     ));
 
-    //AquariumSpriteManager
-    spriteManager = std::make_shared<AquariumSpriteManager>();
-
-    // Lets setup the aquarium
-    myAquarium = std::make_shared<Aquarium>(ofGetWindowWidth(), ofGetWindowHeight(), spriteManager);
-    int x = ofGetWindowWidth()/2 - 50;
-    int y = ofGetWindowHeight()/2 - 50;
-    int speed = DEFAULT_SPEED;
-
-    player = std::make_shared<PlayerCreature>(x, y, speed, spriteManager->GetSprite(AquariumCreatureType::NPCreature));
-
-    player->setDirection(0, 0); // Initially stationary
-    player->setBounds(ofGetWindowWidth() - 20, ofGetWindowHeight() - 20);
-
-
-    myAquarium->addAquariumLevel(std::make_shared<Level_0>(0, 10));
-    myAquarium->addAquariumLevel(std::make_shared<Level_1>(1, 15));
-    myAquarium->addAquariumLevel(std::make_shared<Level_2>(2, 20));
-    myAquarium->addAquariumLevel(std::make_shared<Level_3>(3, 25)); // Fast fish appear
-    myAquarium->addAquariumLevel(std::make_shared<Level_4>(4, 30));
-    myAquarium->Repopulate(); // initial population
+    gameManager->AddScene(GameSceneKind::GAME_OVER, std::make_shared<GameOverScene>(
+        GameSceneKindToString(GameSceneKind::GAME_OVER), gameOverBanner
+    ));
 
-    // now that we are mostly set, lets pass the player and the aquarium downstream
-    gameManager->AddScene(std::make_shared<AquariumGameScene>(
-        std::move(player), std::move(myAquarium), GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)
-    )); // player and aquarium are owned by the scene moving forward
-
-    // Load font for game over message
-    gameOverTitle.load("Verdana.ttf", 12, true, true);
-    gameOverTitle.setLineHeight(34.0f);
-    gameOverTitle.setLetterSpacing(1.035);
+    assetLoader->start();
 
+    ofSetLogLevel(OF_LOG_NOTICE); 
 
-    gameManager->AddScene(std::make_shared<GameOverScene>(
-        GameSceneKindToString(GameSceneKind::GAME_OVER),
-        std::make_shared<GameSprite>("game-over.png", ofGetWindowWidth(), ofGetWindowHeight())
-    ));
+}
 
-    ofSetLogLevel(OF_LOG_NOTICE); 
+//--------------------------------------------------------------
+void ofApp::setupAquariumScene(){
+
+    aquariumScene = CreateAquariumGame(worldWidth, worldHeight, spriteManager, sessionSeed, kAquariumPlayerSpeed,
+                                       GameSceneKindToString(GameSceneKind::AQUARIUM_GAME));
+    // player and aquarium are owned by the scene moving forward
+    aquariumScene->GetEvents().subscribe([this](const GameEvent& event) {
+        lastEvent = event;
+        if(event.isGameOver()){
+            gameManager->Transition(GameSceneKind::GAME_OVER);
+        }
+    });
+    gameManager->AddScene(GameSceneKind::AQUARIUM_GAME, aquariumScene);
 
+    if(!recordPath.empty() && recorder.open(recordPath, sessionSeed, worldWidth, worldHeight)){
+        ofLogNotice() << "Recording session to " << recordPath << " with seed " << sessionSeed;
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
+
+    FrameProfiler::instance().beginFrame();
+    AQUARIUM_PROFILE("app.update");
+    assetLoader->update();
     
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::GAME_OVER)){
+    if(gameManager->IsActive(GameSceneKind::GAME_OVER)){
+        if(replaying){ ofExit(); } // the recorded session ended here as well
         return; // Stop updating if game is over or exiting
     }
 
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
-        auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
-        if(gameScene->GetLastEvent() != nullptr && gameScene->GetLastEvent()->isGameOver()){
-            gameManager->Transition(GameSceneKindToString(GameSceneKind::GAME_OVER));
-            return;
-        }
-        
+    if(gameManager->IsActive(GameSceneKind::AQUARIUM_GAME)){
+        if(!feedGameScene(*aquariumScene)) return;
+        gameManager->UpdateActiveScene();
+        // hand this frame's events to the subscribers, this may leave the scene
+        aquariumScene->GetEvents().dispatch();
+        return;
+    }
+
+    // a replay skips the intro as soon as the game is loaded
+    if(replaying && aquariumScene){
+        gameManager->Transition(GameSceneKind::AQUARIUM_GAME);
+        return;
     }
 
     gameManager->UpdateActiveScene();
-    
 
+}
 
+//--------------------------------------------------------------
+bool ofApp::feedGameScene(AquariumGameScene& scene){
+    // input and frame time come from the keyboard and the clock, or from the replay
+    double frameSeconds = ofGetLastFrameTime();
+    if(replaying && !replay.nextFrame(frameSeconds, pendingInput)){
+        ofLogNotice() << "Replay finished";
+        ofExit();
+        return false;
+    }
+    for(const auto &command : pendingInput){
+        scene.HandleInput(command);
+    }
+    recorder.recordFrame(frameSeconds, pendingInput);
+    pendingInput.clear();
+    scene.SetFrameTime(frameSeconds);
+    return true;
 }
 
 //--------------------------------------------------------------
 void ofApp::draw(){
-    backgroundImage.draw(0, 0);
+    AQUARIUM_PROFILE("app.draw");
+    if (backgroundImage.isAllocated()) backgroundImage.draw(0, 0);
     gameManager->DrawActiveScene();
 }
 
 //--------------------------------------------------------------
 void ofApp::exit(){
-    
+    recorder.close();
+    // per zone summary of the last frames, to compare builds
+    FrameProfiler::instance().writeCsv(ofToDataPath("profile.csv"));
 }
 
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
+    if (key == OF_KEY_F3) {
+        FrameProfiler &profiler = FrameProfiler::instance();
+        profiler.setOverlayVisible(!profiler.isOverlayVisible());
+        return;
+    }
+    if (key == OF_KEY_F4 && aquariumScene) {
+        // compare the "aquarium.hud" zone with and without the cached layer
+        aquariumScene->setHudCached(!aquariumScene->isHudCached());
+        ofLogNotice() << "HUD cache " << (aquariumScene->isHudCached() ? "on" : "off");
+        return;
+    }
+    if (key == OF_KEY_F5 && aquariumScene) {
+        aquariumScene->SaveSnapshot(ofToDataPath("aquarium.snapshot"));
+        return;
+    }
+    if (key == OF_KEY_F9 && aquariumScene) {
+        // a recording or replay only stays valid if nothing restores in between
+        if (recorder.isOpen() || replaying) return;
+        if (aquariumScene->LoadSnapshot(ofToDataPath("aquarium.snapshot"))) pendingInput.clear();
+        return;
+    }
     if (lastEvent.isGameExit()) { 
         ofLogNotice() << "Game has ended. Press ESC to exit." << std::endl;
         return; // Ignore other keys after game over
     }
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
-        auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
-        switch(key){
-            case OF_KEY_UP:
-                gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, -1);
-                break;
-                case OF_KEY_DOWN:
-                gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, 1);
-                break;
-            case OF_KEY_LEFT:
-                gameScene->GetPlayer()->setDirection(-1, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-                gameScene->GetPlayer()->setFlipped(true);
-                break;
-                case OF_KEY_RIGHT:
-                gameScene->GetPlayer()->setDirection(1, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-                gameScene->GetPlayer()->setFlipped(false);
-                break;
-            default:
-                break;
-        }
-    
-        
-    
-        gameScene->GetPlayer()->move();
+    if (replaying) { return; } // the recording drives the game
+    if(gameManager->IsActive(GameSceneKind::AQUARIUM_GAME)){
+        // applied at the start of the next update, so recordings see them in order
+        InputKey inputKey;
+        if (ToInputKey(key, inputKey)) pendingInput.push_back(InputCommand{inputKey, true});
         return;
 
     }
 
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::GAME_INTRO)){
+    if(gameManager->IsActive(GameSceneKind::GAME_INTRO)){
         switch (key)
         {
-        case OF_KEY_SPACE:
-            gameManager->Transition(GameSceneKindToString(GameSceneKind::AQUARIUM_GAME));
+        case OF_KEY_SPACE: // ignored until the game scene exists
+            gameManager->Transition(GameSceneKind::AQUARIUM_GAME);
             break;
         
         default:
@@ -151,20 +207,10 @@ void ofApp::keyPressed(int key){
 
 //--------------------------------------------------------------
 void ofApp::keyReleased(int key){
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
-        auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
-    if( key == OF_KEY_UP || key == OF_KEY_DOWN){
-        gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, 0);
-        gameScene->GetPlayer()->move();
-        return;
-    }
-    
-    if(key == OF_KEY_LEFT || key == OF_KEY_RIGHT){
-        gameScene->GetPlayer()->setDirection(0, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-        gameScene->GetPlayer()->move();
-        return;
-    }
-
+    if (replaying) { return; }
+    if(gameManager->IsActive(GameSceneKind::AQUARIUM_GAME)){
+        InputKey inputKey;
+        if (ToInputKey(key, inputKey)) pendingInput.push_back(InputCommand{inputKey, false});
     }
 }
 
@@ -205,11 +251,8 @@ void ofApp::mouseExited(int x, int y){
 
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h){
-    backgroundImage.resize(w, h);
-    auto aquariumScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetScene(GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)));
-    aquariumScene->GetAquarium()->setBounds(w,h);
-    aquariumScene->GetPlayer()->setBounds(w - 20, h - 20);
-
+    // only the view changes, the camera picks up the new window size when drawing
+    if (backgroundImage.isAllocated()) backgroundImage.resize(w, h);
 }
 
 //--------------------------------------------------------------
@@ -24,13 +24,23 @@ class ofApp : public ofBaseApp{
 		void windowResized(int w, int h) override;
 		void dragEvent(ofDragInfo dragInfo) override;
 		void gotMessage(ofMessage msg) override;
-	
-		
-		char moveDirection;
-		int DEFAULT_SPEED = 5;
-
 
-		AwaitFrames acuariumUpdate{5};
+		// Builds the aquarium scene once its sprites are loaded
+		void setupAquariumScene();
+		// Feeds one frame of input and time to the game, live or replayed,
+		// before the scene manager updates it; false once a replay has ended
+		bool feedGameScene(AquariumGameScene& scene);
+
+		// Session recording and replay, set from the command line in main.cpp
+		std::string recordPath;
+		std::string replayPath;
+		uint64_t sessionSeed = 0; // 0 picks one from the clock
+		SessionRecorder recorder;
+		SessionReplay replay;
+		bool replaying = false;
+		std::vector<InputCommand> pendingInput; // arrow keys since the last update
+		int worldWidth = 0;  // 0 uses the window size
+		int worldHeight = 0;
 
 		ofTrueTypeFont gameOverTitle;
 		GameEvent lastEvent;
@@ -38,7 +48,9 @@ class ofApp : public ofBaseApp{
 
 		ofImage backgroundImage;
 
+		std::shared_ptr<AssetLoader> assetLoader;
 		std::unique_ptr<GameSceneManager> gameManager;
+		std::shared_ptr<AquariumGameScene> aquariumScene; // typed handle to the AQUARIUM_GAME slot, once loaded
 		std::shared_ptr<AquariumSpriteManager>spriteManager;
 		
 };